@@ -0,0 +1,403 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+/*
+ * Benchmark driver: solves every cell of a suite with every engine and pebble
+ * encoding, writes one CSV row per run, and compares the rows with a stored
+ * baseline.
+ *
+ * A suite has one line per DAG: a generator spec (see generators.h) or the
+ * name of a built-in DAG, then the deadlines and the register counts to
+ * solve, each as MIN:MAX or a single value. '#' starts a comment.
+ *
+ * The rows come in the order of the suite, so two runs of the same suite can
+ * be compared line by line. The columns before build_ms only change with the
+ * encoding or the answer; the times come last.
+ */
+
+#include <z3++.h>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <getopt.h>
+
+#include "datastruct.h"
+#include "sat-version.h"
+#include "builtin-dags.h"
+#include "generators.h"
+
+using namespace z3;
+
+typedef struct bench_case {
+	std::string spec;
+	uint32_t minDeadline, maxDeadline;
+	uint32_t minRegisters, maxRegisters;
+} bench_case;
+
+typedef struct bench_row {
+	std::string dagName;
+	uint32_t nbNodes;
+	std::string engine;
+	std::string pebbles;
+	uint32_t deadline;
+	uint32_t registers;
+	std::string result; // sat, unsat or unknown (timeout)
+	uint64_t nbVariables;
+	uint64_t nbConstraints;
+	uint64_t nbTerms;
+	double buildMs;
+	double solveMs;
+} bench_row;
+
+#define BENCH_CSV_HEADER "dag,nodes,engine,pebbles,deadline,registers,result,variables,constraints,terms,build_ms,solve_ms"
+
+void usage(char* name);
+bool parseBenchRange(const std::string& text, uint32_t& min, uint32_t& max);
+bool readSuite(const char* path, std::vector<bench_case>& cases);
+bool parseList(const char* text, const char** names, uint32_t nbNames, std::vector<uint32_t>& selected);
+bench_row runCell(const dag* d, bench_case& c, encoding_engine engine, pebble_encoding pebbles,
+		uint32_t deadline, uint32_t registers, uint32_t timeoutMs);
+std::string rowKey(bench_row& row);
+void writeRow(bench_row& r, std::ostream& out);
+bool readRows(const char* path, std::vector<bench_row>& rows);
+bool diffRows(std::vector<bench_row>& rows, std::vector<bench_row>& baseline, std::ostream& out);
+
+const char* engineNames[] = { "interval", "liveness" };
+
+void usage(char* name) {
+	std::cout << "Usage: " << name << " [options]" << std::endl;
+	std::cout << "Options:" << std::endl;
+	std::cout << "  --suite=FILE           DAGs, deadlines and register counts (default: bench/suite.txt)" << std::endl;
+	std::cout << "  --out=FILE             write the results as CSV (default: stdout)" << std::endl;
+	std::cout << "  --baseline=FILE        compare the results with a previous CSV; the exit status is 1 if" << std::endl;
+	std::cout << "                         a cell went from sat to unsat or back" << std::endl;
+	std::cout << "  --update-baseline      write the results to the baseline instead of comparing them" << std::endl;
+	std::cout << "  --engines=LIST         comma-separated engines (default: interval,liveness)" << std::endl;
+	std::cout << "  --pebbles=LIST         comma-separated pebble encodings (default: all of them)" << std::endl;
+	std::cout << "  --timeout=S            per solve, in seconds; a timeout is reported as unknown (default: 10)" << std::endl;
+	exit(1);
+}
+
+bool parseBenchRange(const std::string& text, uint32_t& min, uint32_t& max) {
+	char* end;
+	min = (uint32_t)strtoul(text.c_str(), &end, 10);
+	max = min;
+	if(*end == ':')
+		max = (uint32_t)strtoul(end + 1, &end, 10);
+	return *end == '\0' && min <= max;
+}
+
+bool readSuite(const char* path, std::vector<bench_case>& cases) {
+	std::ifstream in(path);
+	if(!in) {
+		std::cerr << "Can't read the suite " << path << std::endl;
+		return false;
+	}
+	std::string line;
+	uint32_t lineNumber = 0;
+	while(std::getline(in, line)) {
+		lineNumber++;
+		size_t comment = line.find('#');
+		if(comment != std::string::npos)
+			line.erase(comment);
+		std::istringstream fields(line);
+		bench_case c;
+		std::string deadlines, registers;
+		if(!(fields >> c.spec))
+			continue;
+		if(!(fields >> deadlines >> registers)
+				|| !parseBenchRange(deadlines, c.minDeadline, c.maxDeadline)
+				|| !parseBenchRange(registers, c.minRegisters, c.maxRegisters)) {
+			std::cerr << path << ":" << std::to_string(lineNumber) << ": expected SPEC DEADLINES REGISTERS" << std::endl;
+			return false;
+		}
+		cases.push_back(c);
+	}
+	return true;
+}
+
+bool parseList(const char* text, const char** names, uint32_t nbNames, std::vector<uint32_t>& selected) {
+	std::istringstream items(text);
+	std::string item;
+	while(std::getline(items, item, ',')) {
+		uint32_t i = 0;
+		while(i < nbNames && item != names[i])
+			i++;
+		if(i == nbNames)
+			return false;
+		selected.push_back(i);
+	}
+	return !selected.empty();
+}
+
+bench_row runCell(const dag* d, bench_case& c, encoding_engine engine, pebble_encoding pebbles,
+		uint32_t deadline, uint32_t registers, uint32_t timeoutMs) {
+	bench_row row;
+	row.dagName = c.spec;
+	row.nbNodes = d->nbNodes;
+	row.engine = engineNames[engine];
+	row.pebbles = pebbleEncodingNames[pebbles];
+	row.deadline = deadline;
+	row.registers = registers;
+
+	encoding_options options;
+	options.engine = engine;
+	options.pebbles = pebbles;
+	options.amo = AMO_PB;
+	options.intervalCache = true;
+	options.eventWindows = true;
+	options.symmetryBreaking = true;
+	options.orderingLemmas = true;
+	options.ioBudget = NO_IO_BUDGET;
+	options.minRegisters = NO_SYMBOLIC_REGISTERS;
+
+	context ctx;
+	expr_vector constraints(ctx);
+	symbol_table symbols;
+
+	// The encoders print their progress: keep the CSV readable on stdout
+	std::streambuf* printed = std::cout.rdbuf(NULL);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	dagToConstraints(d, registers, deadline, options, ctx, constraints, symbols);
+	std::chrono::steady_clock::time_point built = std::chrono::steady_clock::now();
+	std::cout.rdbuf(printed);
+	std::cout.clear();
+	row.nbTerms = formulaSize(constraints, &row.nbVariables);
+	row.nbConstraints = constraints.size();
+
+	std::chrono::steady_clock::time_point solveStart = std::chrono::steady_clock::now();
+	solver s = isPureBoolean(options) ? solver(ctx, "QF_FD") : solver(ctx);
+	params p(ctx);
+	p.set("timeout", timeoutMs);
+	s.set(p);
+	check_result result = unknown;
+	try {
+		s.add(mk_and(constraints).simplify());
+		result = s.check();
+	} catch(exception& e) {
+		result = unknown;
+	}
+	std::chrono::steady_clock::time_point solved = std::chrono::steady_clock::now();
+	row.solveMs = std::chrono::duration<double, std::milli>(solved - solveStart).count();
+
+	row.result = (result == sat ? "sat" : (result == unsat ? "unsat" : "unknown"));
+	row.buildMs = std::chrono::duration<double, std::milli>(built - start).count();
+	return row;
+}
+
+std::string rowKey(bench_row& row) {
+	return row.dagName + " " + row.engine + " " + row.pebbles + " deadline " + std::to_string(row.deadline)
+			+ " registers " + std::to_string(row.registers);
+}
+
+void writeRow(bench_row& r, std::ostream& out) {
+	out.setf(std::ios::fixed);
+	out.precision(1);
+	out << r.dagName << "," << r.nbNodes << "," << r.engine << "," << r.pebbles << ","
+			<< r.deadline << "," << r.registers << "," << r.result << ","
+			<< r.nbVariables << "," << r.nbConstraints << "," << r.nbTerms << ","
+			<< r.buildMs << "," << r.solveMs << std::endl;
+}
+
+bool readRows(const char* path, std::vector<bench_row>& rows) {
+	std::ifstream in(path);
+	std::string line;
+	if(!in || !std::getline(in, line) || line != BENCH_CSV_HEADER) {
+		std::cerr << "Can't read the baseline " << path << std::endl;
+		return false;
+	}
+	while(std::getline(in, line)) {
+		std::istringstream fields(line);
+		std::vector<std::string> f;
+		std::string field;
+		while(std::getline(fields, field, ','))
+			f.push_back(field);
+		if(f.size() != 12) {
+			std::cerr << "Malformed baseline row: " << line << std::endl;
+			return false;
+		}
+		bench_row r = { f[0], (uint32_t)std::stoul(f[1]), f[2], f[3], (uint32_t)std::stoul(f[4]),
+				(uint32_t)std::stoul(f[5]), f[6], std::stoull(f[7]), std::stoull(f[8]), std::stoull(f[9]),
+				std::stod(f[10]), std::stod(f[11]) };
+		rows.push_back(r);
+	}
+	return true;
+}
+
+// Answers that contradict the baseline are errors; an unknown on either side
+// isn't. Size changes are listed, times are summed per DAG over the runs
+// that concluded on both sides.
+bool diffRows(std::vector<bench_row>& rows, std::vector<bench_row>& baseline, std::ostream& out) {
+	std::map<std::string, bench_row*> previous;
+	for(uint32_t i = 0; i < baseline.size(); ++i)
+		previous[rowKey(baseline[i])] = &baseline[i];
+
+	bool consistent = true;
+	uint32_t nbCompared = 0, nbNew = 0, nbSizeChanges = 0;
+	std::vector<std::string> dagOrder;
+	std::map<std::string, std::pair<double, double> > times;
+	for(uint32_t i = 0; i < rows.size(); ++i) {
+		bench_row& now = rows[i];
+		std::map<std::string, bench_row*>::iterator found = previous.find(rowKey(now));
+		if(found == previous.end()) {
+			nbNew++;
+			continue;
+		}
+		bench_row& before = *found->second;
+		previous.erase(found);
+		nbCompared++;
+
+		if(now.result != before.result) {
+			bool conflict = (now.result != "unknown" && before.result != "unknown");
+			if(conflict)
+				consistent = false;
+			out << (conflict ? "CONFLICT " : "changed  ") << rowKey(now) << ": " << before.result
+					<< " -> " << now.result << std::endl;
+		}
+		if(now.nbVariables != before.nbVariables || now.nbTerms != before.nbTerms) {
+			nbSizeChanges++;
+			out << "size     " << rowKey(now) << ": " << before.nbVariables << " -> " << now.nbVariables
+					<< " variables, " << before.nbTerms << " -> " << now.nbTerms << " terms" << std::endl;
+		}
+		if(now.result != "unknown" && before.result != "unknown") {
+			if(times.count(now.dagName) == 0)
+				dagOrder.push_back(now.dagName);
+			times[now.dagName].first += before.buildMs + before.solveMs;
+			times[now.dagName].second += now.buildMs + now.solveMs;
+		}
+	}
+
+	out << "# " << nbCompared << " runs compared, " << nbNew << " new, " << previous.size()
+			<< " missing from this run, " << nbSizeChanges << " with another formula size" << std::endl;
+	out.setf(std::ios::fixed);
+	out.precision(1);
+	for(uint32_t i = 0; i < dagOrder.size(); ++i) {
+		std::pair<double, double>& t = times[dagOrder[i]];
+		out << "# " << dagOrder[i] << ": " << t.first << " -> " << t.second << " ms";
+		if(t.first > 0)
+			out << " (" << std::setprecision(2) << t.second / t.first << "x)" << std::setprecision(1);
+		out << std::endl;
+	}
+	if(!consistent)
+		out << "# Some answers contradict the baseline" << std::endl;
+	return consistent;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* suitePath = "bench/suite.txt";
+	const char* outPath = NULL;
+	const char* baselinePath = NULL;
+	bool updateBaseline = false;
+	std::vector<uint32_t> engines, pebbles;
+	uint32_t timeoutMs = 10000;
+
+	static struct option longOptions[] = {
+		{ "suite", required_argument, 0, 's' },
+		{ "out", required_argument, 0, 'o' },
+		{ "baseline", required_argument, 0, 'b' },
+		{ "update-baseline", no_argument, 0, 'u' },
+		{ "engines", required_argument, 0, 'e' },
+		{ "pebbles", required_argument, 0, 'p' },
+		{ "timeout", required_argument, 0, 't' },
+		{ 0, 0, 0, 0 }
+	};
+
+	int opt;
+	while((opt = getopt_long(argc, argv, "", longOptions, NULL)) != -1) {
+		switch(opt) {
+		case 's':
+			suitePath = optarg;
+			break;
+		case 'o':
+			outPath = optarg;
+			break;
+		case 'b':
+			baselinePath = optarg;
+			break;
+		case 'u':
+			updateBaseline = true;
+			break;
+		case 'e':
+			if(!parseList(optarg, engineNames, 2, engines))
+				usage(argv[0]);
+			break;
+		case 'p':
+			if(!parseList(optarg, pebbleEncodingNames, NB_PEBBLE_ENCODINGS, pebbles))
+				usage(argv[0]);
+			break;
+		case 't':
+			timeoutMs = (uint32_t)atoi(optarg) * 1000;
+			if(timeoutMs == 0)
+				usage(argv[0]);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if(optind != argc || (updateBaseline && baselinePath == NULL))
+		usage(argv[0]);
+	if(engines.empty())
+		engines = { ENGINE_INTERVAL, ENGINE_LIVENESS };
+	if(pebbles.empty()) {
+		for(uint32_t i = 0; i < NB_PEBBLE_ENCODINGS; ++i)
+			pebbles.push_back(i);
+	}
+
+	std::vector<bench_case> cases;
+	if(!readSuite(suitePath, cases))
+		return 2;
+	std::vector<bench_row> baseline;
+	if(baselinePath != NULL && !updateBaseline && !readRows(baselinePath, baseline))
+		return 2;
+
+	// Rows are written as they come, so that a long suite shows its progress
+	const char* resultsPath = updateBaseline ? baselinePath : outPath;
+	std::ofstream file;
+	if(resultsPath != NULL) {
+		file.open(resultsPath);
+		if(!file) {
+			std::cerr << "Can't write " << resultsPath << std::endl;
+			return 2;
+		}
+	}
+	std::ostream& out = (resultsPath != NULL ? file : std::cout);
+	out << BENCH_CSV_HEADER << std::endl;
+
+	// One thread per solve, so that the times compare across machines and runs
+	set_param("parallel.enable", false);
+
+	std::vector<bench_row> rows;
+	for(uint32_t i = 0; i < cases.size(); ++i) {
+		bench_case& c = cases[i];
+		dag* d = generateDAG(c.spec.c_str());
+		if(d == NULL)
+			d = builtinDAG(c.spec.c_str());
+		if(d == NULL) {
+			std::cerr << "No generator or built-in DAG for " << c.spec << std::endl;
+			return 2;
+		}
+		std::cerr << "# " << c.spec << ": " << std::to_string(d->nbNodes) << " nodes" << std::endl;
+		for(uint32_t deadline = c.minDeadline; deadline <= c.maxDeadline; ++deadline)
+			for(uint32_t registers = c.minRegisters; registers <= c.maxRegisters; ++registers)
+				for(uint32_t e = 0; e < engines.size(); ++e)
+					for(uint32_t p = 0; p < pebbles.size(); ++p) {
+						rows.push_back(runCell(d, c, (encoding_engine)engines[e], (pebble_encoding)pebbles[p],
+								deadline, registers, timeoutMs));
+						writeRow(rows.back(), out);
+					}
+	}
+
+	if(baselinePath != NULL && !updateBaseline)
+		return diffRows(rows, baseline, std::cerr) ? 0 : 1;
+	return 0;
+}
@@ -0,0 +1,31 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+/*
+ * DAGs compiled into the program, selected by name with --builtin.
+ */
+
+#ifndef BUILTIN_DAGS_H_
+#define BUILTIN_DAGS_H_
+
+#include <iostream>
+#include "datastruct.h"
+
+typedef struct builtin_dag {
+    const char* name;
+    uint32_t nbNodes;
+    uint32_t maxDeps; // width of the dependence matrix
+    const uint32_t* deps;
+} builtin_dag;
+
+#define DEFAULT_BUILTIN_DAG "fft4"
+
+builtin_dag* findBuiltinDAG(const char* name);
+// NULL if there is no such DAG
+dag* builtinDAG(const char* name);
+void listBuiltinDAGs(std::ostream& out);
+
+#endif /* BUILTIN_DAGS_H_ */
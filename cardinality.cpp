@@ -0,0 +1,314 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+#include "cardinality.h"
+#include <algorithm>
+
+expr freshBool(context& ctx, const char* prefix);
+expr_vector totalizer(expr_vector& literals, uint32_t lo, uint32_t hi, uint32_t nbOutputs, context& ctx, expr_vector& constraints);
+expr_vector totalizerMerge(expr_vector& a, expr_vector& b, uint32_t size, context& ctx, expr_vector& constraints);
+std::vector<expr> sortedMerge(std::vector<expr>& a, std::vector<expr>& b, context& ctx, expr_vector& constraints);
+expr_vector sortingNetwork(expr_vector& literals, uint32_t nbOutputs, context& ctx, expr_vector& constraints);
+void comparator(std::vector<expr>& wires, uint32_t i, uint32_t j, context& ctx, expr_vector& constraints);
+void oddEvenMergeSort(std::vector<expr>& wires, uint32_t lo, uint32_t n, context& ctx, expr_vector& constraints);
+void oddEvenMerge(std::vector<expr>& wires, uint32_t lo, uint32_t n, uint32_t r, context& ctx, expr_vector& constraints);
+void atMostOnePairwise(expr_vector& literals, expr_vector& constraints);
+
+expr freshBool(context& ctx, const char* prefix) {
+	// Z3 makes the name unique in the context
+	return expr(ctx, Z3_mk_fresh_const(ctx, prefix, ctx.bool_sort()));
+}
+
+//// AT MOST K
+
+std::vector<expr_vector> sequentialCounter(expr_vector& literals, uint32_t nbOutputs, context& ctx, expr_vector& constraints) {
+	std::vector<expr_vector> rows;
+
+	for(uint32_t i = 0; i < literals.size(); ++i) {
+		expr x = literals[i];
+		expr_vector row(ctx);
+		uint32_t rowSize = std::min(nbOutputs, i + 1);
+
+		for(uint32_t j = 0; j < rowSize; ++j) {
+			expr s = freshBool(ctx, "seq");
+			// count of the previous prefix carries over
+			if(i > 0 && j < rows[i-1].size())
+				constraints.push_back(!rows[i-1][j] || s);
+			// x increments it
+			if(j == 0)
+				constraints.push_back(!x || s);
+			else
+				constraints.push_back(!x || !rows[i-1][j-1] || s);
+			row.push_back(s);
+		}
+		rows.push_back(row);
+	}
+
+	return rows;
+}
+
+expr_vector totalizer(expr_vector& literals, uint32_t lo, uint32_t hi, uint32_t nbOutputs, context& ctx, expr_vector& constraints) {
+	expr_vector ret(ctx);
+	if(hi - lo == 1) {
+		ret.push_back(literals[lo]);
+		return ret;
+	}
+
+	uint32_t mid = lo + (hi - lo) / 2;
+	expr_vector a = totalizer(literals, lo, mid, nbOutputs, ctx, constraints);
+	expr_vector b = totalizer(literals, mid, hi, nbOutputs, ctx, constraints);
+	return totalizerMerge(a, b, std::min(nbOutputs, hi - lo), ctx, constraints);
+}
+
+// Unary sum of two unary counts, truncated to size outputs
+expr_vector totalizerMerge(expr_vector& a, expr_vector& b, uint32_t size, context& ctx, expr_vector& constraints) {
+	expr_vector ret(ctx);
+	for(uint32_t k = 0; k < size; ++k)
+		ret.push_back(freshBool(ctx, "tot"));
+
+	// a[i] AND b[j] => ret[i + j + 1], with i or j = -1 standing for "true"
+	for(int32_t i = -1; i < (int32_t)a.size(); ++i) {
+		for(int32_t j = -1; j < (int32_t)b.size(); ++j) {
+			uint32_t k = i + j + 1;
+			if((i < 0 && j < 0) || k >= size)
+				continue;
+			if(i < 0)
+				constraints.push_back(!b[j] || ret[k]);
+			else if(j < 0)
+				constraints.push_back(!a[i] || ret[k]);
+			else
+				constraints.push_back(!a[i] || !b[j] || ret[k]);
+		}
+	}
+
+	return ret;
+}
+
+void comparator(std::vector<expr>& wires, uint32_t i, uint32_t j, context& ctx, expr_vector& constraints) {
+	// Sorts in decreasing order: the max goes to i, the min to j.
+	// Only the upward implications are needed for an upper bound.
+	expr a = wires[i];
+	expr b = wires[j];
+	if(b.is_false())
+		return;
+	if(a.is_false()) {
+		wires[i] = b;
+		wires[j] = a;
+		return;
+	}
+	expr max = freshBool(ctx, "sort");
+	expr min = freshBool(ctx, "sort");
+	constraints.push_back(!a || max);
+	constraints.push_back(!b || max);
+	constraints.push_back(!a || !b || min);
+	wires[i] = max;
+	wires[j] = min;
+}
+
+void oddEvenMerge(std::vector<expr>& wires, uint32_t lo, uint32_t n, uint32_t r, context& ctx, expr_vector& constraints) {
+	uint32_t step = r * 2;
+	if(step < n) {
+		oddEvenMerge(wires, lo, n, step, ctx, constraints);
+		oddEvenMerge(wires, lo + r, n, step, ctx, constraints);
+		for(uint32_t i = lo + r; i + r < lo + n; i += step)
+			comparator(wires, i, i + r, ctx, constraints);
+	} else {
+		comparator(wires, lo, lo + r, ctx, constraints);
+	}
+}
+
+void oddEvenMergeSort(std::vector<expr>& wires, uint32_t lo, uint32_t n, context& ctx, expr_vector& constraints) {
+	if(n > 1) {
+		uint32_t m = n / 2;
+		oddEvenMergeSort(wires, lo, m, ctx, constraints);
+		oddEvenMergeSort(wires, lo + m, m, ctx, constraints);
+		oddEvenMerge(wires, lo, n, 1, ctx, constraints);
+	}
+}
+
+expr_vector sortingNetwork(expr_vector& literals, uint32_t nbOutputs, context& ctx, expr_vector& constraints) {
+	// Pad up to a power of 2 with constant false wires
+	uint32_t n = 1;
+	while(n < literals.size())
+		n *= 2;
+	std::vector<expr> wires;
+	for(uint32_t i = 0; i < n; ++i)
+		wires.push_back(i < literals.size() ? literals[i] : ctx.bool_val(false));
+
+	oddEvenMergeSort(wires, 0, n, ctx, constraints);
+
+	expr_vector ret(ctx);
+	for(uint32_t i = 0; i < std::min(nbOutputs, (uint32_t)literals.size()); ++i)
+		ret.push_back(wires[i]);
+	return ret;
+}
+
+// Batcher's odd-even merge of two decreasing sequences of any lengths: merge
+// the even and the odd positions separately, then one layer of comparators
+std::vector<expr> sortedMerge(std::vector<expr>& a, std::vector<expr>& b, context& ctx, expr_vector& constraints) {
+	if(a.empty())
+		return b;
+	if(b.empty())
+		return a;
+	if(a.size() == 1 && b.size() == 1) {
+		std::vector<expr> wires = { a[0], b[0] };
+		comparator(wires, 0, 1, ctx, constraints);
+		return wires;
+	}
+
+	std::vector<expr> aEven, aOdd, bEven, bOdd;
+	for(uint32_t i = 0; i < a.size(); ++i)
+		(i % 2 == 0 ? aEven : aOdd).push_back(a[i]);
+	for(uint32_t i = 0; i < b.size(); ++i)
+		(i % 2 == 0 ? bEven : bOdd).push_back(b[i]);
+	std::vector<expr> even = sortedMerge(aEven, bEven, ctx, constraints);
+	std::vector<expr> odd = sortedMerge(aOdd, bOdd, ctx, constraints);
+
+	// even has 0 to 2 more ones than odd: only even[i + 1] and odd[i] can be
+	// out of order
+	std::vector<expr> ret;
+	ret.push_back(even[0]);
+	uint32_t i = 0;
+	for(; i < odd.size() && i + 1 < even.size(); ++i) {
+		std::vector<expr> wires = { even[i + 1], odd[i] };
+		comparator(wires, 0, 1, ctx, constraints);
+		ret.push_back(wires[0]);
+		ret.push_back(wires[1]);
+	}
+	for(uint32_t j = i; j < odd.size(); ++j)
+		ret.push_back(odd[j]);
+	for(uint32_t j = i + 1; j < even.size(); ++j)
+		ret.push_back(even[j]);
+	return ret;
+}
+
+expr_vector unaryCounter(expr_vector& literals, uint32_t nbOutputs, card_encoding encoding, context& ctx, expr_vector& constraints) {
+	if(literals.size() == 0 || nbOutputs == 0)
+		return expr_vector(ctx);
+
+	switch(encoding) {
+	case CARD_TOTALIZER:
+		return totalizer(literals, 0, literals.size(), nbOutputs, ctx, constraints);
+	case CARD_SORTING_NETWORK:
+		return sortingNetwork(literals, nbOutputs, ctx, constraints);
+	case CARD_SEQUENTIAL_COUNTER:
+	default:
+		return sequentialCounter(literals, nbOutputs, ctx, constraints).back();
+	}
+}
+
+std::vector<expr_vector> prefixCounters(expr_vector& literals, uint32_t blockSize, uint32_t nbOutputs, card_encoding encoding, context& ctx, expr_vector& constraints) {
+	std::vector<expr_vector> rows;
+	if(encoding == CARD_SEQUENTIAL_COUNTER) {
+		std::vector<expr_vector> counter = sequentialCounter(literals, nbOutputs, ctx, constraints);
+		for(uint32_t end = blockSize; end <= literals.size(); end += blockSize)
+			rows.push_back(counter[end - 1]);
+		return rows;
+	}
+
+	// Each row is the previous one plus the count of its block
+	expr_vector row(ctx);
+	for(uint32_t lo = 0; lo + blockSize <= literals.size(); lo += blockSize) {
+		expr_vector block(ctx);
+		for(uint32_t i = lo; i < lo + blockSize; ++i)
+			block.push_back(literals[i]);
+		expr_vector blockCount = unaryCounter(block, nbOutputs, encoding, ctx, constraints);
+		uint32_t size = std::min(nbOutputs, lo + blockSize);
+		if(encoding == CARD_TOTALIZER) {
+			row = totalizerMerge(row, blockCount, size, ctx, constraints);
+		} else {
+			// The first size outputs of the merge only depend on the first
+			// size wires of each side
+			std::vector<expr> a, b;
+			for(uint32_t i = 0; i < row.size(); ++i)
+				a.push_back(row[i]);
+			for(uint32_t i = 0; i < blockCount.size(); ++i)
+				b.push_back(blockCount[i]);
+			std::vector<expr> merged = sortedMerge(a, b, ctx, constraints);
+			row = expr_vector(ctx);
+			for(uint32_t i = 0; i < size; ++i)
+				row.push_back(merged[i]);
+		}
+		rows.push_back(row);
+	}
+	return rows;
+}
+
+void atMostK(expr_vector& literals, uint32_t k, card_encoding encoding, context& ctx, expr_vector& constraints) {
+	if(literals.size() <= k)
+		return; // trivially satisfied
+
+	if(k == 0) {
+		for(uint32_t i = 0; i < literals.size(); ++i)
+			constraints.push_back(!literals[i]);
+		return;
+	}
+
+	expr_vector count = unaryCounter(literals, k + 1, encoding, ctx, constraints);
+	constraints.push_back(!count[k]);
+}
+
+//// AT MOST ONE
+
+void atMostOnePairwise(expr_vector& literals, expr_vector& constraints) {
+	for(uint32_t i = 0; i < literals.size(); ++i)
+		for(uint32_t j = i + 1; j < literals.size(); ++j)
+			constraints.push_back(!literals[i] || !literals[j]);
+}
+
+void atMostOne(expr_vector& literals, amo_encoding encoding, context& ctx, expr_vector& constraints) {
+	if(literals.size() <= 1)
+		return;
+
+	switch(encoding) {
+	case AMO_PB:
+		constraints.push_back(atmost(literals, 1));
+		break;
+
+	case AMO_PAIRWISE:
+		atMostOnePairwise(literals, constraints);
+		break;
+
+	case AMO_LADDER: {
+		// y[i] <=> one of literals 0..i is true
+		expr previous = ctx.bool_val(false);
+		for(uint32_t i = 0; i < literals.size(); ++i) {
+			expr x = literals[i];
+			if(i > 0)
+				constraints.push_back(!x || !previous);
+			if(i + 1 < literals.size()) {
+				expr y = freshBool(ctx, "ladder");
+				constraints.push_back(!x || y);
+				if(i > 0)
+					constraints.push_back(!previous || y);
+				previous = y;
+			}
+		}
+		break;
+	}
+
+	case AMO_COMMANDER: {
+		if(literals.size() <= 4) {
+			atMostOnePairwise(literals, constraints);
+			break;
+		}
+		// Groups of 3, each with a commander implied by its members
+		expr_vector commanders(ctx);
+		for(uint32_t i = 0; i < literals.size(); i += 3) {
+			expr_vector group(ctx);
+			for(uint32_t j = i; j < std::min(i + 3, (uint32_t)literals.size()); ++j)
+				group.push_back(literals[j]);
+			atMostOnePairwise(group, constraints);
+			expr c = freshBool(ctx, "cmd");
+			for(uint32_t j = 0; j < group.size(); ++j)
+				constraints.push_back(!group[j] || c);
+			commanders.push_back(c);
+		}
+		atMostOne(commanders, AMO_COMMANDER, ctx, constraints);
+		break;
+	}
+	}
+}
@@ -0,0 +1,53 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+/*
+ * Pure-CNF cardinality constraints. Every encoding only emits clauses over
+ * Boolean variables, so that the problem can stay in Z3's SAT core (or any
+ * CDCL solver) instead of going through linear arithmetic or pseudo-Booleans.
+ */
+
+#ifndef CARDINALITY_H_
+#define CARDINALITY_H_
+
+#include <z3++.h>
+#include <vector>
+
+using namespace z3;
+
+// At-most-k encodings
+typedef enum card_encoding {
+	CARD_SEQUENTIAL_COUNTER, // Sinz 2005
+	CARD_TOTALIZER,          // Bailleux & Boufkhad 2003
+	CARD_SORTING_NETWORK     // Batcher's odd-even merge sort
+} card_encoding;
+
+// At-most-one encodings
+typedef enum amo_encoding {
+	AMO_PB,       // Z3's native atmost(): not pure CNF
+	AMO_PAIRWISE,
+	AMO_LADDER,
+	AMO_COMMANDER // Klieber & Kwon 2007, groups of 3
+} amo_encoding;
+
+// Unary count of the literals: output j is implied by "at least j+1 literals are true".
+// Only the first nbOutputs outputs are built.
+expr_vector unaryCounter(expr_vector& literals, uint32_t nbOutputs, card_encoding encoding, context& ctx, expr_vector& constraints);
+
+// Sequential counter over every prefix of the literals: row i is the unary count
+// of literals 0..i, as in unaryCounter.
+std::vector<expr_vector> sequentialCounter(expr_vector& literals, uint32_t nbOutputs, context& ctx, expr_vector& constraints);
+
+// Unary counts of the prefixes that end on a block boundary: row i counts
+// literals 0..(i+1)*blockSize-1. One structure serves every prefix: the
+// sequential counter's rows, or a chain of totalizer or odd-even merges that
+// adds each block's count to the previous row.
+std::vector<expr_vector> prefixCounters(expr_vector& literals, uint32_t blockSize, uint32_t nbOutputs, card_encoding encoding, context& ctx, expr_vector& constraints);
+
+void atMostK(expr_vector& literals, uint32_t k, card_encoding encoding, context& ctx, expr_vector& constraints);
+void atMostOne(expr_vector& literals, amo_encoding encoding, context& ctx, expr_vector& constraints);
+
+#endif /* CARDINALITY_H_ */
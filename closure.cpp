@@ -0,0 +1,94 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+#include "closure.h"
+#include <algorithm>
+
+inline bool testBit(const uint64_t* row, node n) {
+	return (row[n / 64] >> (n % 64)) & 1;
+}
+
+bool reachabilityClosure(const dag* d, reach_closure& closure) {
+	closure.nbNodes = d->nbNodes;
+	closure.nbWords = (d->nbNodes + 63) / 64;
+	closure.levels.clear();
+	if(d->nbNodes > CLOSURE_MAX_NODES)
+		return false;
+
+	std::vector<node> order(d->nbNodes);
+	if(!topologicalOrder(d, order.data()))
+		return false;
+
+	uint32_t nbWords = closure.nbWords;
+	closure.levels.assign(CLOSURE_MAX_DISTANCE, std::vector<uint64_t>((size_t)d->nbNodes * nbWords, 0));
+	for(uint32_t k = 0; k < CLOSURE_MAX_DISTANCE; ++k) {
+		uint64_t* level = closure.levels[k].data();
+		const uint64_t* below = k > 0 ? closure.levels[k - 1].data() : level;
+		// Successors first, so that their rows are complete
+		for(uint32_t i = d->nbNodes; i-- > 0; ) {
+			node a = order[i];
+			uint64_t* row = level + (size_t)a * nbWords;
+			for(uint32_t j = 0; j < nbSuccessors(d, a); ++j) {
+				node s = successors(d, a)[j];
+				const uint64_t* from = below + (size_t)s * nbWords;
+				for(uint32_t w = 0; w < nbWords; ++w)
+					row[w] |= from[w];
+				if(k == 0)
+					row[s / 64] |= (uint64_t)1 << (s % 64);
+			}
+		}
+	}
+	return true;
+}
+
+uint32_t pathLength(reach_closure& closure, node a, node b) {
+	uint32_t length = 0;
+	while(length < CLOSURE_MAX_DISTANCE && testBit(closure.levels[length].data() + (size_t)a * closure.nbWords, b))
+		length++;
+	return length;
+}
+
+uint64_t orderingLemmas(run_context& run, reach_closure& closure, context& ctx, expr_vector& constraints,
+		symbol_table& symbols, prefix_cache& prefixes) {
+	const dag* d = run.graph;
+	uint32_t maxTime = run.maxTime;
+	uint64_t nbLemmas = 0;
+	if(maxTime == 0)
+		return 0;
+	for(node a = 0; a < d->nbNodes; ++a) {
+		if(nbPredecessors(d, a) == 0)
+			continue; // loaded, not computed
+		const uint64_t* row = closure.levels[0].data() + (size_t)a * closure.nbWords;
+		for(uint32_t w = 0; w < closure.nbWords; ++w) {
+			for(uint64_t bits = row[w]; bits != 0; bits &= bits - 1) {
+				node b = w * 64 + __builtin_ctzll(bits);
+				uint32_t length = pathLength(closure, a, b);
+
+				for(uint32_t t = run.asap[b]; t <= std::min(run.alap[b], maxTime - 1); ++t) {
+					registered_symbol* computeB = findRegisteredSymbol(b, RULE_R3, t, symbols);
+					if(computeB == NULL)
+						continue;
+
+					expr aBefore = t >= length ? computedBy(a, t - length, ctx, constraints, symbols, prefixes) : ctx.bool_val(false);
+					constraints.push_back(implies(computeB->symbol, aBefore));
+					nbLemmas += 1;
+
+					uint32_t first = t + 1 > length ? t + 1 - length : 0;
+					for(uint32_t tt = first; tt <= t + 1 && tt < maxTime; ++tt) {
+						if(tt == t)
+							continue;
+						registered_symbol* computeA = findRegisteredSymbol(a, RULE_R3, tt, symbols);
+						if(computeA == NULL)
+							continue;
+						constraints.push_back(!computeA->symbol || !computeB->symbol);
+						nbLemmas += 1;
+					}
+				}
+			}
+		}
+	}
+	return nbLemmas;
+}
@@ -0,0 +1,57 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+/*
+ * Reachability closure and the redundant constraints it gives. Every non-input
+ * node is computed exactly once and no two events share a date, so if a path
+ * of L edges goes from a to b, b is computed at least L dates after a:
+ *
+ * - ordering lemma: R3(b,t) implies some R3(a,t') with t' <= t - L;
+ * - incompatibility lemma: R3(a,t') and R3(b,t) can't both hold when
+ *   t - L < t' < t, nor when t' = t + 1 (the same date is already excluded).
+ *
+ * Both already follow from the encoding, but only through the dependences of
+ * every node of the path; written down, they propagate at once.
+ *
+ * The closure is kept as one bitset of 64-bit words per node and distance:
+ * level k of node a holds the nodes reached from a by a path of more than k
+ * edges. Each level is an OR of rows of the level below over the successors.
+ */
+
+#ifndef CLOSURE_H_
+#define CLOSURE_H_
+
+#include <z3++.h>
+#include <vector>
+#include "datastruct.h"
+#include "sat-version.h"
+
+using namespace z3;
+
+// Above this many nodes, the closure (nodes^2 bits per level) isn't built
+#define CLOSURE_MAX_NODES 8192
+// Longer paths count as this many edges
+#define CLOSURE_MAX_DISTANCE 8
+
+typedef struct reach_closure {
+	uint32_t nbNodes;
+	uint32_t nbWords; // per row
+	// levels[k][a * nbWords + w]: word w of the nodes reached from a by a
+	// path of k + 1 edges or more
+	std::vector<std::vector<uint64_t> > levels;
+} reach_closure;
+
+// False if the DAG is too large or has a cycle
+bool reachabilityClosure(const dag* d, reach_closure& closure);
+// Length of the longest path from a to b, up to CLOSURE_MAX_DISTANCE; 0 if b
+// isn't reached from a
+uint32_t pathLength(reach_closure& closure, node a, node b);
+
+// Returns the number of lemmas
+uint64_t orderingLemmas(run_context& run, reach_closure& closure, context& ctx, expr_vector& constraints,
+		symbol_table& symbols, prefix_cache& prefixes);
+
+#endif /* CLOSURE_H_ */
@@ -0,0 +1,279 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+#include "dagio.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+bool parseUInt(const char*& p, uint64_t& value);
+bool checkOffsets(const uint64_t* offsets, uint32_t nbNodes, uint64_t nbEdges);
+bool checkIndices(const uint32_t* indices, uint64_t nbEdges, uint32_t nbNodes);
+bool checkTranspose(const uint64_t* predOffsets, const uint32_t* predIndices, const uint64_t* succOffsets,
+        const uint32_t* succIndices, uint32_t nbNodes);
+bool rejectCycles(const dag* d, const char* path);
+void freeLists(dag* d);
+
+// Skips blanks, then reads a decimal number
+bool parseUInt(const char*& p, uint64_t& value) {
+    while(*p == ' ' || *p == '\t')
+        p++;
+    if(*p < '0' || *p > '9')
+        return false;
+    value = 0;
+    while(*p >= '0' && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        if(value > UINT32_MAX)
+            return false;
+        p++;
+    }
+    return true;
+}
+
+dag* loadEdgeList(const char* path) {
+    FILE* f = fopen(path, "r");
+    if(f == NULL) {
+        cerr << path << ": " << strerror(errno) << endl;
+        return NULL;
+    }
+
+    vector<uint32_t> from, to;
+    unordered_set<uint64_t> edges;
+    uint64_t nbNodes = 0;
+    bool haveNodes = false;
+    char* line = NULL;
+    size_t capacity = 0;
+    uint64_t lineNumber = 0;
+    bool ok = true;
+    bool duplicate = false;
+
+    while(ok && getline(&line, &capacity, f) != -1) {
+        lineNumber++;
+        const char* p = line;
+        while(*p == ' ' || *p == '\t')
+            p++;
+        if(*p == '#' || *p == '\n' || *p == '\r' || *p == '\0')
+            continue;
+
+        uint64_t u, v;
+        if(strncmp(p, "nodes", 5) == 0) {
+            p += 5;
+            ok = !haveNodes && parseUInt(p, nbNodes);
+            haveNodes = true;
+        } else {
+            ok = haveNodes && parseUInt(p, u) && parseUInt(p, v)
+                    && u >= 1 && u <= nbNodes && v >= 1 && v <= nbNodes && u != v;
+            // The encoders would count such an edge twice
+            duplicate = ok && !edges.insert((u << 32) | v).second;
+            ok = ok && !duplicate;
+            if(ok) {
+                from.push_back(u - 1);
+                to.push_back(v - 1);
+            }
+        }
+        while(ok && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+            p++;
+        ok = ok && (*p == '\0' || *p == '#');
+    }
+    free(line);
+    fclose(f);
+
+    if(duplicate) {
+        cerr << path << ":" << lineNumber << ": duplicate edge" << endl;
+        return NULL;
+    }
+    if(!ok) {
+        cerr << path << ":" << lineNumber << ": expected \"nodes N\" once, then \"u v\" edges between 1 and N" << endl;
+        return NULL;
+    }
+    if(!haveNodes) {
+        cerr << path << ": no \"nodes N\" line" << endl;
+        return NULL;
+    }
+
+    dag* d = edgeListToDAG((uint32_t)nbNodes, from.size(), from.data(), to.data());
+    if(rejectCycles(d, path)) {
+        // The CSR arrays are one block, starting with predOffsets
+        free((void*)d->predOffsets);
+        freeLists(d);
+        return NULL;
+    }
+    return d;
+}
+
+// A cycle is an error in the input, not an unsat instance: the encoders
+// assume a DAG
+bool rejectCycles(const dag* d, const char* path) {
+    vector<node> order(d->nbNodes);
+    if(!topologicalOrder(d, order.data())) {
+        cerr << path << ": the graph has a cycle" << endl;
+        return true;
+    }
+    return false;
+}
+
+// Frees what csrToDAG allocated, not the CSR arrays
+void freeLists(dag* d) {
+    free(d->inputNodes);
+    free(d);
+}
+
+bool checkOffsets(const uint64_t* offsets, uint32_t nbNodes, uint64_t nbEdges) {
+    if(offsets[0] != 0 || offsets[nbNodes] != nbEdges)
+        return false;
+    for(uint32_t i = 0; i < nbNodes; i++) {
+        if(offsets[i] > offsets[i + 1])
+            return false;
+    }
+    return true;
+}
+
+bool checkIndices(const uint32_t* indices, uint64_t nbEdges, uint32_t nbNodes) {
+    for(uint64_t e = 0; e < nbEdges; e++) {
+        if(indices[e] >= nbNodes)
+            return false;
+    }
+    return true;
+}
+
+// The successor lists must hold exactly the edges of the predecessor lists:
+// the encoders read some relations from one half and some from the other
+bool checkTranspose(const uint64_t* predOffsets, const uint32_t* predIndices, const uint64_t* succOffsets,
+        const uint32_t* succIndices, uint32_t nbNodes) {
+    vector<uint64_t> fill(nbNodes + 1, 0);
+    for(node v = 0; v < nbNodes; v++) {
+        for(uint64_t e = predOffsets[v]; e < predOffsets[v + 1]; e++)
+            fill[predIndices[e] + 1] += 1;
+    }
+    for(node u = 0; u < nbNodes; u++) {
+        fill[u + 1] += fill[u];
+        if(fill[u + 1] != succOffsets[u + 1])
+            return false;
+    }
+
+    vector<uint32_t> expected(predOffsets[nbNodes]);
+    for(node v = 0; v < nbNodes; v++) {
+        for(uint64_t e = predOffsets[v]; e < predOffsets[v + 1]; e++)
+            expected[fill[predIndices[e]]++] = v;
+    }
+    vector<uint32_t> found(succIndices, succIndices + succOffsets[nbNodes]);
+    for(node u = 0; u < nbNodes; u++) {
+        sort(expected.begin() + succOffsets[u], expected.begin() + succOffsets[u + 1]);
+        sort(found.begin() + succOffsets[u], found.begin() + succOffsets[u + 1]);
+    }
+    return expected == found;
+}
+
+dag* loadBinaryDAG(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        cerr << path << ": " << strerror(errno) << endl;
+        return NULL;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(binary_dag_header)) {
+        cerr << path << ": too short for a binary DAG" << endl;
+        close(fd);
+        return NULL;
+    }
+
+    // A loaded DAG points into the mapping, which then lives as long as the program
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) {
+        cerr << path << ": " << strerror(errno) << endl;
+        return NULL;
+    }
+
+    const binary_dag_header* header = (const binary_dag_header*)map;
+    uint64_t nbNodes = header->nbNodes;
+    uint64_t nbEdges = header->nbEdges;
+    // Each edge takes 8 bytes, which bounds nbEdges before computing the size
+    uint64_t expectedSize = sizeof(binary_dag_header) + 2 * (nbNodes + 1) * sizeof(uint64_t)
+            + 2 * nbEdges * sizeof(uint32_t);
+    if(memcmp(header->magic, BINARY_DAG_MAGIC, 8) != 0 || header->version != BINARY_DAG_VERSION
+            || nbEdges > (uint64_t)st.st_size || (uint64_t)st.st_size != expectedSize) {
+        cerr << path << ": not a version " << BINARY_DAG_VERSION << " binary DAG, or truncated" << endl;
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    const char* base = (const char*)map + sizeof(binary_dag_header);
+    const uint64_t* predOffsets = (const uint64_t*)base;
+    const uint64_t* succOffsets = predOffsets + nbNodes + 1;
+    const uint32_t* predIndices = (const uint32_t*)(succOffsets + nbNodes + 1);
+    const uint32_t* succIndices = predIndices + nbEdges;
+
+    if(!checkOffsets(predOffsets, nbNodes, nbEdges) || !checkOffsets(succOffsets, nbNodes, nbEdges)
+            || !checkIndices(predIndices, nbEdges, nbNodes) || !checkIndices(succIndices, nbEdges, nbNodes)) {
+        cerr << path << ": inconsistent CSR arrays" << endl;
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    if(!checkTranspose(predOffsets, predIndices, succOffsets, succIndices, nbNodes)) {
+        cerr << path << ": the successor lists don't match the predecessor lists" << endl;
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    dag* d = csrToDAG((uint32_t)nbNodes, nbEdges, predOffsets, predIndices, succOffsets, succIndices);
+    if(rejectCycles(d, path)) {
+        freeLists(d);
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    return d;
+}
+
+dag* loadDAGFile(const char* path) {
+    char magic[8];
+    FILE* f = fopen(path, "rb");
+    if(f == NULL) {
+        cerr << path << ": " << strerror(errno) << endl;
+        return NULL;
+    }
+    bool binary = (fread(magic, 1, 8, f) == 8) && memcmp(magic, BINARY_DAG_MAGIC, 8) == 0;
+    fclose(f);
+
+    return binary ? loadBinaryDAG(path) : loadEdgeList(path);
+}
+
+bool writeBinaryDAG(const dag* d, const char* path) {
+    FILE* f = fopen(path, "wb");
+    if(f == NULL) {
+        cerr << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+
+    binary_dag_header header;
+    memcpy(header.magic, BINARY_DAG_MAGIC, 8);
+    header.version = BINARY_DAG_VERSION;
+    header.nbNodes = d->nbNodes;
+    header.nbEdges = d->nbEdges;
+
+    size_t nbOffsets = d->nbNodes + 1;
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1
+            && fwrite(d->predOffsets, sizeof(uint64_t), nbOffsets, f) == nbOffsets
+            && fwrite(d->succOffsets, sizeof(uint64_t), nbOffsets, f) == nbOffsets
+            && fwrite(d->predIndices, sizeof(uint32_t), d->nbEdges, f) == d->nbEdges
+            && fwrite(d->succIndices, sizeof(uint32_t), d->nbEdges, f) == d->nbEdges;
+    ok = (fclose(f) == 0) && ok;
+
+    if(!ok)
+        cerr << path << ": write failed" << endl;
+    return ok;
+}
@@ -0,0 +1,53 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+/*
+ * DAGs loaded at runtime, in two formats.
+ *
+ * Text edge list, read line by line:
+ *   # comment
+ *   nodes 5        number of nodes, before any edge
+ *   1 3            node 1 is a predecessor of node 3 (nodes numbered from 1,
+ *                  each edge at most once)
+ *
+ * Binary CSR, mapped in memory and used in place by the DAG (native byte order):
+ *   char     magic[8]                 "LBSATCSR"
+ *   uint32_t version                  1
+ *   uint32_t nbNodes
+ *   uint64_t nbEdges
+ *   uint64_t predOffsets[nbNodes + 1]
+ *   uint64_t succOffsets[nbNodes + 1]
+ *   uint32_t predIndices[nbEdges]     0-based
+ *   uint32_t succIndices[nbEdges]
+ * Both offset arrays start at 0 and end at nbEdges, and each half must be the
+ * transpose of the other.
+ */
+
+#ifndef DAGIO_H_
+#define DAGIO_H_
+
+#include "datastruct.h"
+
+#define BINARY_DAG_MAGIC "LBSATCSR"
+#define BINARY_DAG_VERSION 1
+
+typedef struct binary_dag_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t nbNodes;
+    uint64_t nbEdges;
+} binary_dag_header;
+
+// These return NULL, after printing why, if the file can't be read or the
+// graph isn't a DAG
+dag* loadEdgeList(const char* path);
+dag* loadBinaryDAG(const char* path);
+// Either format, told apart by the magic
+dag* loadDAGFile(const char* path);
+
+bool writeBinaryDAG(const dag* d, const char* path);
+
+#endif /* DAGIO_H_ */
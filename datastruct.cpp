@@ -15,54 +15,56 @@
 
 using namespace std;
 
-int isInput(node n) {
-    return (n.nbPredecessors == 0);
+int isInput(const dag* d, node n) {
+    return (nbPredecessors(d, n) == 0);
 }
 
-int isOutput(node n) {
-    return (n.nbSuccessors == 0);
+int isOutput(const dag* d, node n) {
+    return (nbSuccessors(d, n) == 0);
 }
 
-dag* createDAGStructure(node* nodes, uint32_t nbNodes) {
+dag* csrToDAG(uint32_t nbNodes, uint64_t nbEdges, const uint64_t* predOffsets, const uint32_t* predIndices,
+        const uint64_t* succOffsets, const uint32_t* succIndices) {
     dag* d = (dag*)malloc(sizeof(dag));
+    assert(d != NULL);
+    node i;
 
-    uint32_t i;
-
-    d->allNodes = nodes;
     d->nbNodes = nbNodes;
-    d->inputNodes = NULL;
-    d->outputNodes = NULL;
+    d->nbEdges = nbEdges;
+    d->predOffsets = predOffsets;
+    d->predIndices = predIndices;
+    d->succOffsets = succOffsets;
+    d->succIndices = succIndices;
+
     d->nbInputNodes = 0;
     d->nbOutputNodes = 0;
+    for(i = 0; i < nbNodes; i++) {
+        if(isInput(d, i))
+            d->nbInputNodes += 1;
+        if(isOutput(d, i))
+            d->nbOutputNodes += 1;
+    }
 
+    // One block for the input/output lists
+    size_t nbWords = (size_t)d->nbInputNodes + d->nbOutputNodes;
+    uint32_t* arena = (uint32_t*)malloc(nbWords * sizeof(uint32_t) + 1);
+    assert(arena != NULL);
+    d->inputNodes = arena;
+    d->outputNodes = d->inputNodes + d->nbInputNodes;
 
-    // Build input nodes
-    for(i = 0; i < d->nbNodes; i++) {
-        node n = d->allNodes[i];
-        if(isInput(n)) {
+    uint32_t nbInputs = 0, nbOutputs = 0;
+    for(i = 0; i < nbNodes; i++) {
+        if(isInput(d, i)) {
 #ifdef DEBUG
             cout << to_string(i+1) << " is input" << endl;
 #endif
-            d->nbInputNodes += 1;
-            d->inputNodes = (node**)realloc(d->inputNodes, d->nbInputNodes *
-                sizeof(node*));
-            assert(d->inputNodes != NULL);
-
-            d->inputNodes[d->nbInputNodes - 1] = &(d->allNodes[i]);
+            d->inputNodes[nbInputs++] = i;
         }
-    }
-
-    // Build output nodes
-    for(i = 0; i < d->nbNodes; i++) {
-        node n = d->allNodes[i];
-        if(isOutput(n)) {
+        if(isOutput(d, i)) {
 #ifdef DEBUG
             cout << to_string(i+1) << " is output" << endl;
 #endif
-            d->nbOutputNodes += 1;
-            d->outputNodes = (node**)realloc(d->outputNodes, d->nbOutputNodes *
-                sizeof(node*));
-            d->outputNodes[d->nbOutputNodes - 1] = &(d->allNodes[i]);
+            d->outputNodes[nbOutputs++] = i;
         }
     }
 #ifdef DEBUG
@@ -72,37 +74,66 @@ dag* createDAGStructure(node* nodes, uint32_t nbNodes) {
     return d;
 }
 
-node* matrixToNodes(uint32_t deps[][MAX_DEPS], uint32_t nbNodes) {
-    uint32_t i = 0, j = 0;
-    node* dagNodes = (node*)calloc(nbNodes, sizeof(node));
+dag* edgeListToDAG(uint32_t nbNodes, uint64_t nbEdges, const uint32_t* from, const uint32_t* to) {
+    // One block for the CSR arrays, laid out as in the binary format
+    size_t nbOffsets = (size_t)nbNodes + 1;
+    char* arena = (char*)calloc(1, 2 * nbOffsets * sizeof(uint64_t) + 2 * nbEdges * sizeof(uint32_t));
+    assert(arena != NULL);
+    uint64_t* predOffsets = (uint64_t*)arena;
+    uint64_t* succOffsets = predOffsets + nbOffsets;
+    uint32_t* predIndices = (uint32_t*)(succOffsets + nbOffsets);
+    uint32_t* succIndices = predIndices + nbEdges;
+    uint64_t e;
+    uint32_t i;
 
+    // Counting sort of the edges by target, then by source
+    for(e = 0; e < nbEdges; e++) {
+        predOffsets[to[e] + 1] += 1;
+        succOffsets[from[e] + 1] += 1;
+    }
     for(i = 0; i < nbNodes; i++) {
-        dagNodes[i].num = i + 1;
-        dagNodes[i].asap = UINT32_MAX;
-        dagNodes[i].alap = 0;
-        dagNodes[i].deleted = false;
-        for(j = 0; j < MAX_DEPS; j++) {
-            uint32_t dep = deps[i][j];
-            if(dep > 0) {
-#ifdef DEBUG
-                cout << to_string(i + 1) << " -> " << to_string(dep) << endl;
-#endif
-                dep -= 1; // convention !!
-                dagNodes[i].nbPredecessors += 1;
-                dagNodes[i].predecessors = (node**)realloc(dagNodes[i].predecessors,
-                                dagNodes[i].nbPredecessors * sizeof(node*));
-                dagNodes[i].predecessors[dagNodes[i].nbPredecessors - 1] =
-                                &(dagNodes[dep]);
-
-                dagNodes[dep].nbSuccessors += 1;
-                dagNodes[dep].successors = (node**)realloc(dagNodes[dep].successors,
-                                dagNodes[dep].nbSuccessors * sizeof(node*));
-                dagNodes[dep].successors[dagNodes[dep].nbSuccessors - 1] =
-                                &(dagNodes[i]);
-            }
-        }
+        predOffsets[i + 1] += predOffsets[i];
+        succOffsets[i + 1] += succOffsets[i];
     }
 
-    return dagNodes;
+    uint64_t* predFill = (uint64_t*)malloc((nbNodes + 1) * sizeof(uint64_t));
+    uint64_t* succFill = (uint64_t*)malloc((nbNodes + 1) * sizeof(uint64_t));
+    assert(predFill != NULL && succFill != NULL);
+    for(i = 0; i <= nbNodes; i++) {
+        predFill[i] = predOffsets[i];
+        succFill[i] = succOffsets[i];
+    }
+    for(e = 0; e < nbEdges; e++) {
+        predIndices[predFill[to[e]]++] = from[e];
+        succIndices[succFill[from[e]]++] = to[e];
+    }
+    free(predFill);
+    free(succFill);
+
+    return csrToDAG(nbNodes, nbEdges, predOffsets, predIndices, succOffsets, succIndices);
+}
+
+bool topologicalOrder(const dag* d, node* order) {
+    // Kahn's algorithm, with order[] doubling as the queue
+    uint32_t* pending = (uint32_t*)malloc(d->nbNodes * sizeof(uint32_t) + 1);
+    assert(pending != NULL);
+    uint32_t head = 0, tail = 0;
+    node n;
+
+    for(n = 0; n < d->nbNodes; n++) {
+        pending[n] = nbPredecessors(d, n);
+        if(pending[n] == 0)
+            order[tail++] = n;
+    }
+    while(head < tail) {
+        n = order[head++];
+        const node* succs = successors(d, n);
+        for(uint32_t i = 0; i < nbSuccessors(d, n); i++) {
+            if(--pending[succs[i]] == 0)
+                order[tail++] = succs[i];
+        }
+    }
+    free(pending);
 
+    return tail == d->nbNodes;
 }
@@ -16,9 +16,6 @@
 
 #include <cstdint>
 
-// Hardcoded value for the max number of dependences for one single node.
-#define MAX_DEPS 2
-
 typedef enum rule {
     NONE, // WARNING do not move !!
     RULE_R1,
@@ -27,36 +24,66 @@ typedef enum rule {
     RULE_R4
 } rule;
 
-typedef struct node {
-    struct node** predecessors;
-    uint32_t nbPredecessors;
-
-    // redundant ! but useful !
-    struct node** successors;
-    uint32_t nbSuccessors;
-
-    uint32_t num;
-
-    uint32_t asap;
-    uint32_t alap;
+// Nodes are numbered from 0 in the DAG, and from 1 (num = node + 1) in the
+// symbol names and the input files.
+typedef uint32_t node;
 
-    bool deleted;
+#define NO_NODE UINT32_MAX
 
-} node;
+// One entry of a time-indexed schedule.
+typedef struct schedule_event {
+    node n; // NO_NODE if nothing happens at this date
+    rule r;
+} schedule_event;
 
+// Read-only once built: the data of one solve (ASAP/ALAP for a horizon,
+// pebbles) lives elsewhere, so that concurrent solves can share one DAG.
 typedef struct dag {
-    node** inputNodes;
+    uint32_t nbNodes;
+    uint64_t nbEdges;
+
+    // Adjacency in CSR form: the predecessors of node n are
+    // predIndices[predOffsets[n]] to predIndices[predOffsets[n+1] - 1], and
+    // likewise for the successors. No bound on the arity. For a binary DAG
+    // file, these point straight into the mapped file (see dagio.h).
+    const uint64_t* predOffsets;
+    const uint32_t* predIndices;
+    const uint64_t* succOffsets;
+    const uint32_t* succIndices;
+
+    node* inputNodes;
     uint32_t nbInputNodes;
 
-    node** outputNodes;
+    node* outputNodes;
     uint32_t nbOutputNodes;
-
-    node* allNodes;
-    uint32_t nbNodes;
 } dag;
 
-
-dag* createDAGStructure(node* nodes, uint32_t nbNodes);
-node* matrixToNodes(uint32_t deps[][MAX_DEPS], uint32_t nbNodes);
+inline uint32_t nbPredecessors(const dag* d, node n) {
+    return (uint32_t)(d->predOffsets[n + 1] - d->predOffsets[n]);
+}
+
+inline const node* predecessors(const dag* d, node n) {
+    return d->predIndices + d->predOffsets[n];
+}
+
+inline uint32_t nbSuccessors(const dag* d, node n) {
+    return (uint32_t)(d->succOffsets[n + 1] - d->succOffsets[n]);
+}
+
+inline const node* successors(const dag* d, node n) {
+    return d->succIndices + d->succOffsets[n];
+}
+
+// Build the DAG around the CSR arrays, which it keeps as is. The input/output
+// lists come from a single allocation.
+dag* csrToDAG(uint32_t nbNodes, uint64_t nbEdges, const uint64_t* predOffsets, const uint32_t* predIndices,
+        const uint64_t* succOffsets, const uint32_t* succIndices);
+// Edge e goes from node from[e] to node to[e]. The predecessors and
+// successors of each node keep the order of the edges.
+dag* edgeListToDAG(uint32_t nbNodes, uint64_t nbEdges, const uint32_t* from, const uint32_t* to);
+
+// Fills order[0..nbNodes-1] so that every node comes after its predecessors.
+// Linear in the number of edges. Returns false if the graph has a cycle.
+bool topologicalOrder(const dag* d, node* order);
 
 #endif /* DATASTRUCT_H_ */
@@ -0,0 +1,236 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+#include "export.h"
+#include <sys/stat.h>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+// Tseitin variables of the compound terms of one flush, by term id. The ids
+// are only stable while the terms are alive, so the cache doesn't outlive it.
+typedef std::unordered_map<unsigned, int32_t> tseitin_cache;
+
+std::string dimacsHeader(constraint_sink& sink);
+void declareConstants(constraint_sink& sink, const expr& e, std::unordered_set<unsigned>& visited);
+void writeClause(constraint_sink& sink, std::vector<int32_t>& literals);
+int32_t trueLiteral(constraint_sink& sink);
+int32_t namedVariable(constraint_sink& sink, const expr& e);
+int32_t tseitinLiteral(constraint_sink& sink, const expr& e, tseitin_cache& cache);
+void assertDIMACS(constraint_sink& sink, const expr& e, tseitin_cache& cache);
+
+// Same width whatever the counts, so it can be rewritten in place
+std::string dimacsHeader(constraint_sink& sink) {
+	std::ostringstream header;
+	header << "p cnf " << std::setw(10) << sink.nbVariables << " " << std::setw(20) << sink.nbClauses;
+	return header.str();
+}
+
+bool openConstraintSink(constraint_sink& sink, const char* path, export_format format) {
+	sink.format = format;
+	sink.nbAssertions = 0;
+	sink.nbVariables = 0;
+	sink.nbClauses = 0;
+	sink.trueVariable = 0;
+	sink.out.open(path, std::ios::out | std::ios::trunc);
+	if(!sink.out) {
+		std::cerr << "Can't write the constraints to " << path << std::endl;
+		return false;
+	}
+	if(format == EXPORT_DIMACS) {
+		struct stat info;
+		if(stat(path, &info) != 0 || !S_ISREG(info.st_mode)) {
+			std::cerr << "DIMACS has its header first: " << path << " has to be a regular file" << std::endl;
+			return false;
+		}
+		sink.out << dimacsHeader(sink) << "\n";
+	} else {
+		sink.out << "; Red-blue pebble game scheduling, from SMT-LB-IO\n";
+	}
+	return true;
+}
+
+void declareConstants(constraint_sink& sink, const expr& e, std::unordered_set<unsigned>& visited) {
+	std::vector<expr> todo;
+	todo.push_back(e);
+	while(!todo.empty()) {
+		expr t = todo.back();
+		todo.pop_back();
+		if(!visited.insert(t.id()).second || !t.is_app())
+			continue;
+		if(t.is_const() && t.decl().decl_kind() == Z3_OP_UNINTERPRETED) {
+			if(sink.declared.insert(t.decl().name().str()).second)
+				sink.out << t.decl() << "\n";
+			continue;
+		}
+		for(unsigned i = 0; i < t.num_args(); ++i)
+			todo.push_back(t.arg(i));
+	}
+}
+
+void writeClause(constraint_sink& sink, std::vector<int32_t>& literals) {
+	for(uint32_t i = 0; i < literals.size(); ++i)
+		sink.out << literals[i] << " ";
+	sink.out << "0\n";
+	sink.nbClauses += 1;
+}
+
+int32_t trueLiteral(constraint_sink& sink) {
+	if(sink.trueVariable == 0) {
+		sink.trueVariable = ++sink.nbVariables;
+		std::vector<int32_t> unit(1, sink.trueVariable);
+		writeClause(sink, unit);
+	}
+	return sink.trueVariable;
+}
+
+int32_t namedVariable(constraint_sink& sink, const expr& e) {
+	std::string name = e.decl().name().str();
+	std::unordered_map<std::string, int32_t>::iterator found = sink.variables.find(name);
+	if(found != sink.variables.end())
+		return found->second;
+	int32_t v = ++sink.nbVariables;
+	sink.variables[name] = v;
+	// Fresh auxiliaries have a '!' in their name, and nothing to map back to
+	if(name.find('!') == std::string::npos)
+		sink.out << "c var " << v << " " << name << "\n";
+	return v;
+}
+
+int32_t tseitinLiteral(constraint_sink& sink, const expr& e, tseitin_cache& cache) {
+	if(e.is_true())
+		return trueLiteral(sink);
+	if(e.is_false())
+		return -trueLiteral(sink);
+	if(e.is_app() && e.is_const() && e.is_bool() && e.decl().decl_kind() == Z3_OP_UNINTERPRETED)
+		return namedVariable(sink, e);
+	if(!e.is_app() || !e.is_bool()) {
+		if(sink.error.empty())
+			sink.error = "not a Boolean term: " + e.to_string().substr(0, 80);
+		return trueLiteral(sink);
+	}
+	Z3_decl_kind kind = e.decl().decl_kind();
+	if(kind == Z3_OP_NOT)
+		return -tseitinLiteral(sink, e.arg(0), cache);
+
+	tseitin_cache::iterator found = cache.find(e.id());
+	if(found != cache.end())
+		return found->second;
+
+	std::vector<int32_t> args;
+	for(unsigned i = 0; i < e.num_args(); ++i)
+		args.push_back(tseitinLiteral(sink, e.arg(i), cache));
+	if(kind == Z3_OP_IMPLIES) {
+		args[0] = -args[0];
+		kind = Z3_OP_OR;
+	}
+	bool binary = (args.size() == 2 && e.arg(0).is_bool());
+	if(kind == Z3_OP_XOR && binary) {
+		args[1] = -args[1];
+		kind = Z3_OP_IFF;
+	} else if(kind == Z3_OP_EQ && binary) {
+		kind = Z3_OP_IFF;
+	}
+
+	int32_t v = ++sink.nbVariables;
+	std::vector<int32_t> clause;
+	switch(kind) {
+	case Z3_OP_AND:
+		// v -> every argument, and all of them -> v
+		clause.push_back(v);
+		for(uint32_t i = 0; i < args.size(); ++i) {
+			std::vector<int32_t> implied = { -v, args[i] };
+			writeClause(sink, implied);
+			clause.push_back(-args[i]);
+		}
+		writeClause(sink, clause);
+		break;
+	case Z3_OP_OR:
+		clause.push_back(-v);
+		for(uint32_t i = 0; i < args.size(); ++i) {
+			std::vector<int32_t> implied = { v, -args[i] };
+			writeClause(sink, implied);
+			clause.push_back(args[i]);
+		}
+		writeClause(sink, clause);
+		break;
+	case Z3_OP_IFF: {
+		int32_t a = args[0], b = args[1];
+		std::vector<std::vector<int32_t> > clauses = { { -v, -a, b }, { -v, a, -b }, { v, a, b }, { v, -a, -b } };
+		for(uint32_t i = 0; i < clauses.size(); ++i)
+			writeClause(sink, clauses[i]);
+		break;
+	}
+	case Z3_OP_ITE: {
+		int32_t c = args[0], a = args[1], b = args[2];
+		std::vector<std::vector<int32_t> > clauses = { { -v, -c, a }, { -v, c, b }, { v, -c, -a }, { v, c, -b } };
+		for(uint32_t i = 0; i < clauses.size(); ++i)
+			writeClause(sink, clauses[i]);
+		break;
+	}
+	default:
+		if(sink.error.empty())
+			sink.error = "no CNF for " + e.decl().name().str() + " (use a pure-Boolean encoding)";
+	}
+	cache[e.id()] = v;
+	return v;
+}
+
+void assertDIMACS(constraint_sink& sink, const expr& e, tseitin_cache& cache) {
+	if(e.is_true())
+		return;
+	std::vector<int32_t> clause;
+	if(e.is_app()) {
+		Z3_decl_kind kind = e.decl().decl_kind();
+		if(kind == Z3_OP_AND) {
+			for(unsigned i = 0; i < e.num_args(); ++i)
+				assertDIMACS(sink, e.arg(i), cache);
+			return;
+		}
+		if(kind == Z3_OP_OR || kind == Z3_OP_IMPLIES) {
+			for(unsigned i = 0; i < e.num_args(); ++i)
+				clause.push_back(tseitinLiteral(sink, e.arg(i), cache));
+			if(kind == Z3_OP_IMPLIES)
+				clause[0] = -clause[0];
+			writeClause(sink, clause);
+			return;
+		}
+	}
+	// false is the empty clause
+	if(!e.is_false())
+		clause.push_back(tseitinLiteral(sink, e, cache));
+	writeClause(sink, clause);
+}
+
+void writeConstraints(constraint_sink& sink, expr_vector& constraints) {
+	if(sink.format == EXPORT_DIMACS) {
+		tseitin_cache cache;
+		for(unsigned i = 0; i < constraints.size(); ++i)
+			assertDIMACS(sink, constraints[i], cache);
+	} else {
+		std::unordered_set<unsigned> visited;
+		for(unsigned i = 0; i < constraints.size(); ++i) {
+			declareConstants(sink, constraints[i], visited);
+			sink.out << "(assert " << constraints[i] << ")\n";
+		}
+	}
+	sink.nbAssertions += constraints.size();
+	constraints.resize(0);
+}
+
+bool closeConstraintSink(constraint_sink& sink) {
+	if(sink.format == EXPORT_DIMACS) {
+		sink.out.seekp(0);
+		sink.out << dimacsHeader(sink);
+	} else {
+		sink.out << "(check-sat)\n";
+	}
+	sink.out.close();
+	if(!sink.error.empty())
+		std::cerr << "Export incomplete, " << sink.error << std::endl;
+	return sink.error.empty() && !sink.out.fail();
+}
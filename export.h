@@ -0,0 +1,60 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+/*
+ * Export of the constraints to a file or a named pipe, as the builders make
+ * them: each flush writes the pending constraints and empties the vector, so
+ * the whole formula is never held at once.
+ *
+ * - SMT-LIB2: each constant is declared before its first assertion. The
+ *   terms are printed by Z3, with lets for shared sub-terms. The sum and
+ *   prefix encodings use integers, and the pb at-most-one Z3's own at-most,
+ *   which other solvers may not read.
+ * - DIMACS: pure-Boolean encodings only, Tseitin-encoded. Top-level
+ *   conjunctions, disjunctions and implications become clauses directly.
+ *   Constants keep one variable for the whole export; "c var N name" lines
+ *   map the named ones back. The header comes first in DIMACS, so it is
+ *   written padded and rewritten at the end: the output has to be a regular
+ *   file.
+ */
+
+#ifndef EXPORT_H_
+#define EXPORT_H_
+
+#include <z3++.h>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace z3;
+
+typedef enum export_format {
+	EXPORT_SMT2,
+	EXPORT_DIMACS
+} export_format;
+
+typedef struct constraint_sink {
+	export_format format;
+	std::ofstream out;
+	std::string error; // first construct the format can't express, if any
+	uint64_t nbAssertions;
+	// SMT-LIB2: names of the declared constants
+	std::unordered_set<std::string> declared;
+	// DIMACS: variable of each constant, by name (Z3's fresh names are unique)
+	std::unordered_map<std::string, int32_t> variables;
+	int32_t nbVariables;
+	uint64_t nbClauses;
+	int32_t trueVariable; // 0 until a constant true or false is met
+} constraint_sink;
+
+bool openConstraintSink(constraint_sink& sink, const char* path, export_format format);
+// Writes the constraints and empties the vector
+void writeConstraints(constraint_sink& sink, expr_vector& constraints);
+// False if a constraint couldn't be written
+bool closeConstraintSink(constraint_sink& sink);
+
+#endif /* EXPORT_H_ */
@@ -0,0 +1,189 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+#include "generators.h"
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+typedef struct edge_list {
+    std::vector<uint32_t> from;
+    std::vector<uint32_t> to;
+} edge_list;
+
+void addEdge(edge_list& edges, node from, node to);
+bool parseParameters(const char* text, std::vector<uint32_t>& params);
+
+void addEdge(edge_list& edges, node from, node to) {
+    edges.from.push_back(from);
+    edges.to.push_back(to);
+}
+
+dag* fftDAG(uint32_t nbInputs) {
+    if(nbInputs < 2 || (nbInputs & (nbInputs - 1)) != 0)
+        return NULL;
+    edge_list edges;
+    // Stage s holds nodes s * nbInputs to (s + 1) * nbInputs - 1, inputs first
+    uint32_t nbStages = 0;
+    for(uint32_t half = 1; half < nbInputs; half *= 2) {
+        node above = nbStages * nbInputs;
+        node below = above + nbInputs;
+        for(uint32_t i = 0; i < nbInputs; i++) {
+            uint32_t partner = i ^ half;
+            addEdge(edges, above + i, below + i);
+            addEdge(edges, above + partner, below + i);
+        }
+        nbStages++;
+    }
+    return edgeListToDAG((nbStages + 1) * nbInputs, edges.from.size(), edges.from.data(), edges.to.data());
+}
+
+dag* matmultDAG(uint32_t size) {
+    if(size == 0)
+        return NULL;
+    edge_list edges;
+    uint32_t n = size;
+    // A then B, row-major, then the products and sums of each entry of C
+    node next = 2 * n * n;
+    for(uint32_t i = 0; i < n; i++) {
+        for(uint32_t j = 0; j < n; j++) {
+            node sum = NO_NODE;
+            for(uint32_t k = 0; k < n; k++) {
+                node product = next++;
+                addEdge(edges, i * n + k, product);
+                addEdge(edges, n * n + k * n + j, product);
+                if(sum == NO_NODE) {
+                    sum = product;
+                } else {
+                    node partial = next++;
+                    addEdge(edges, sum, partial);
+                    addEdge(edges, product, partial);
+                    sum = partial;
+                }
+            }
+        }
+    }
+    return edgeListToDAG(next, edges.from.size(), edges.from.data(), edges.to.data());
+}
+
+dag* jacobiDAG(uint32_t nbDims, uint32_t size, uint32_t nbSteps) {
+    if(nbDims == 0 || size == 0 || nbSteps == 0)
+        return NULL;
+    uint64_t nbPoints = 1;
+    for(uint32_t d = 0; d < nbDims; d++) {
+        nbPoints *= size;
+        if(nbPoints * (nbSteps + 1) > UINT32_MAX / 2)
+            return NULL;
+    }
+    edge_list edges;
+    // Point p of step t is node t * nbPoints + p; step 0 is the input grid
+    for(uint32_t t = 0; t < nbSteps; t++) {
+        for(uint32_t p = 0; p < nbPoints; p++) {
+            node target = (t + 1) * nbPoints + p;
+            addEdge(edges, t * nbPoints + p, target);
+            uint32_t stride = 1;
+            for(uint32_t d = 0; d < nbDims; d++) {
+                uint32_t coordinate = (p / stride) % size;
+                if(coordinate > 0)
+                    addEdge(edges, t * nbPoints + p - stride, target);
+                if(coordinate + 1 < size)
+                    addEdge(edges, t * nbPoints + p + stride, target);
+                stride *= size;
+            }
+        }
+    }
+    return edgeListToDAG((nbSteps + 1) * nbPoints, edges.from.size(), edges.from.data(), edges.to.data());
+}
+
+dag* layeredDAG(uint32_t nbLayers, uint32_t width, uint32_t degree, uint32_t seed) {
+    if(nbLayers < 2 || width == 0 || degree == 0 || degree > width)
+        return NULL;
+    // mt19937's raw output is fixed by the standard, unlike the distributions
+    std::mt19937 random(seed);
+    std::vector<node> above(width);
+    edge_list edges;
+    for(uint32_t l = 1; l < nbLayers; l++) {
+        for(uint32_t i = 0; i < width; i++) {
+            for(uint32_t k = 0; k < width; k++)
+                above[k] = (l - 1) * width + k;
+            // Partial Fisher-Yates: the first degree entries are the predecessors
+            for(uint32_t k = 0; k < degree; k++) {
+                uint32_t pick = k + random() % (width - k);
+                std::swap(above[k], above[pick]);
+                addEdge(edges, above[k], l * width + i);
+            }
+        }
+    }
+    return edgeListToDAG(nbLayers * width, edges.from.size(), edges.from.data(), edges.to.data());
+}
+
+dag* reductionTreeDAG(uint32_t nbInputs, uint32_t arity) {
+    if(nbInputs < 2 || arity < 2)
+        return NULL;
+    edge_list edges;
+    std::vector<node> level, reduced;
+    for(node i = 0; i < nbInputs; i++)
+        level.push_back(i);
+    node next = nbInputs;
+    while(level.size() > 1) {
+        reduced.clear();
+        for(uint32_t i = 0; i < level.size(); i += arity) {
+            uint32_t end = std::min((uint32_t)level.size(), i + arity);
+            // A lone leftover goes up unchanged
+            if(end - i == 1) {
+                reduced.push_back(level[i]);
+                continue;
+            }
+            for(uint32_t j = i; j < end; j++)
+                addEdge(edges, level[j], next);
+            reduced.push_back(next++);
+        }
+        level.swap(reduced);
+    }
+    return edgeListToDAG(next, edges.from.size(), edges.from.data(), edges.to.data());
+}
+
+// ":p1:p2..." after the family name
+bool parseParameters(const char* text, std::vector<uint32_t>& params) {
+    while(*text == ':') {
+        char* end;
+        unsigned long value = strtoul(text + 1, &end, 10);
+        if(end == text + 1 || value > UINT32_MAX)
+            return false;
+        params.push_back((uint32_t)value);
+        text = end;
+    }
+    return *text == '\0';
+}
+
+dag* generateDAG(const char* spec) {
+    const char* colon = strchr(spec, ':');
+    if(colon == NULL)
+        return NULL;
+    std::string family(spec, colon - spec);
+    std::vector<uint32_t> p;
+    if(!parseParameters(colon, p))
+        return NULL;
+
+    if(family == "fft" && p.size() == 1)
+        return fftDAG(p[0]);
+    if(family == "matmult" && p.size() == 1)
+        return matmultDAG(p[0]);
+    if(family == "jacobi" && p.size() == 3)
+        return jacobiDAG(p[0], p[1], p[2]);
+    if(family == "layered" && p.size() == 4)
+        return layeredDAG(p[0], p[1], p[2], p[3]);
+    if(family == "tree" && p.size() == 2)
+        return reductionTreeDAG(p[0], p[1]);
+    return NULL;
+}
+
+void listDAGFamilies(std::ostream& out) {
+    out << "fft:N, matmult:N, jacobi:D:S:K, layered:L:W:K:SEED, tree:N:A" << std::endl;
+}
@@ -0,0 +1,37 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+/*
+ * Parametric families of DAGs, for the benchmarks and --generate. A family is
+ * named by a spec "family:p1:p2:...":
+ *
+ * - fft:N             radix-2 FFT on N = 2^k inputs, k stages of butterflies
+ * - matmult:N         N x N matrix product, each entry a chain of N products
+ * - jacobi:D:S:K      K steps of the (2D+1)-point stencil on an S^D grid
+ * - layered:L:W:K:SEED  L layers of W nodes, each node after the first layer
+ *                     depends on K distinct random nodes of the layer above
+ * - tree:N:A          reduction of N inputs by A-ary operations
+ *
+ * The same spec always gives the same DAG, on any platform.
+ */
+
+#ifndef GENERATORS_H_
+#define GENERATORS_H_
+
+#include <iostream>
+#include "datastruct.h"
+
+dag* fftDAG(uint32_t nbInputs);
+dag* matmultDAG(uint32_t size);
+dag* jacobiDAG(uint32_t nbDims, uint32_t size, uint32_t nbSteps);
+dag* layeredDAG(uint32_t nbLayers, uint32_t width, uint32_t degree, uint32_t seed);
+dag* reductionTreeDAG(uint32_t nbInputs, uint32_t arity);
+
+// NULL if the spec doesn't name a family with valid parameters
+dag* generateDAG(const char* spec);
+void listDAGFamilies(std::ostream& out);
+
+#endif /* GENERATORS_H_ */
@@ -0,0 +1,214 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+#include "heuristic.h"
+#include "simulator.h"
+#include <algorithm>
+#include <queue>
+
+const char* orderPolicyNames[] = { "index", "depth-first", "critical-path" };
+
+typedef struct ready_node {
+	int64_t key; // highest first
+	node n;      // then lowest number
+} ready_node;
+
+bool operator<(const ready_node& a, const ready_node& b) {
+	if(a.key != b.key)
+		return a.key < b.key;
+	return a.n > b.n;
+}
+
+bool computeOrder(const dag* d, order_policy policy, std::vector<node>& order);
+std::vector<uint32_t> heights(const dag* d);
+bool freeRegister(std::vector<node>& regs, uint32_t nbRedPebbles, std::vector<bool>& pinned,
+		std::vector<std::vector<uint32_t> >& uses, std::vector<uint32_t>& usesDone, greedy_schedule& ret);
+void emit(greedy_schedule& ret, node n, rule r);
+
+// Longest path to an output, in edges
+std::vector<uint32_t> heights(const dag* d) {
+	std::vector<node> topo(d->nbNodes);
+	std::vector<uint32_t> ret(d->nbNodes, 0);
+	if(!topologicalOrder(d, topo.data()))
+		return ret;
+	for(uint32_t i = d->nbNodes; i-- > 0; ) {
+		node n = topo[i];
+		for(uint32_t j = 0; j < nbSuccessors(d, n); ++j)
+			ret[n] = std::max(ret[n], ret[successors(d, n)[j]] + 1);
+	}
+	return ret;
+}
+
+// Non-input nodes only, each one after its predecessors. False on a cycle.
+bool computeOrder(const dag* d, order_policy policy, std::vector<node>& order) {
+	std::vector<uint32_t> height;
+	if(policy == ORDER_CRITICAL_PATH)
+		height = heights(d);
+
+	std::vector<uint32_t> remaining(d->nbNodes, 0);
+	std::priority_queue<ready_node> ready;
+	uint32_t nbComputed = 0;
+	for(node n = 0; n < d->nbNodes; ++n) {
+		if(nbPredecessors(d, n) == 0)
+			continue;
+		nbComputed += 1;
+		for(uint32_t i = 0; i < nbPredecessors(d, n); ++i) {
+			if(nbPredecessors(d, predecessors(d, n)[i]) > 0)
+				remaining[n] += 1;
+		}
+		if(remaining[n] == 0) {
+			ready_node r = { policy == ORDER_CRITICAL_PATH ? (int64_t)height[n] : -1, n };
+			ready.push(r);
+		}
+	}
+
+	order.clear();
+	while(!ready.empty()) {
+		node n = ready.top().n;
+		ready.pop();
+		order.push_back(n);
+		for(uint32_t i = 0; i < nbSuccessors(d, n); ++i) {
+			node s = successors(d, n)[i];
+			if(--remaining[s] > 0)
+				continue;
+			ready_node r = { -1, s };
+			if(policy == ORDER_DEPTH_FIRST)
+				r.key = order.size(); // when its last predecessor was computed
+			else if(policy == ORDER_CRITICAL_PATH)
+				r.key = height[s];
+			ready.push(r);
+		}
+	}
+	return order.size() == nbComputed;
+}
+
+void emit(greedy_schedule& ret, node n, rule r) {
+	schedule_event e = { n, r };
+	ret.events.push_back(e);
+}
+
+// Belady's MIN: the value used the furthest in the future leaves, deleted if
+// it has no use left, stored otherwise
+bool freeRegister(std::vector<node>& regs, uint32_t nbRedPebbles, std::vector<bool>& pinned,
+		std::vector<std::vector<uint32_t> >& uses, std::vector<uint32_t>& usesDone, greedy_schedule& ret) {
+	if(regs.size() < nbRedPebbles)
+		return true;
+	uint32_t victim = UINT32_MAX;
+	uint64_t furthest = 0;
+	for(uint32_t i = 0; i < regs.size(); ++i) {
+		node n = regs[i];
+		if(pinned[n])
+			continue;
+		uint64_t next = usesDone[n] < uses[n].size() ? uses[n][usesDone[n]] : UINT64_MAX;
+		if(victim == UINT32_MAX || next > furthest) {
+			victim = i;
+			furthest = next;
+		}
+	}
+	if(victim == UINT32_MAX)
+		return false;
+	emit(ret, regs[victim], furthest == UINT64_MAX ? RULE_R4 : RULE_R2);
+	regs.erase(regs.begin() + victim);
+	return true;
+}
+
+greedy_schedule greedySchedule(const dag* d, uint32_t nbRedPebbles, order_policy policy) {
+	greedy_schedule ret;
+	ret.found = false;
+	ret.policy = policy;
+	ret.cost = 0;
+
+	std::vector<node> order;
+	if(!computeOrder(d, policy, order))
+		return ret;
+
+	// Positions in the order of the computes that use each value
+	std::vector<uint32_t> position(d->nbNodes, 0);
+	for(uint32_t i = 0; i < order.size(); ++i) {
+		position[order[i]] = i;
+		if(nbPredecessors(d, order[i]) + 1 > nbRedPebbles)
+			return ret;
+	}
+	std::vector<std::vector<uint32_t> > uses(d->nbNodes);
+	for(node n = 0; n < d->nbNodes; ++n) {
+		for(uint32_t i = 0; i < nbSuccessors(d, n); ++i)
+			uses[n].push_back(position[successors(d, n)[i]]);
+		std::sort(uses[n].begin(), uses[n].end());
+	}
+	std::vector<uint32_t> usesDone(d->nbNodes, 0);
+
+	std::vector<node> regs;
+	std::vector<bool> pinned(d->nbNodes, false);
+	for(uint32_t i = 0; i < order.size(); ++i) {
+		node n = order[i];
+		const node* preds = predecessors(d, n);
+		for(uint32_t j = 0; j < nbPredecessors(d, n); ++j)
+			pinned[preds[j]] = true;
+
+		for(uint32_t j = 0; j < nbPredecessors(d, n); ++j) {
+			if(std::find(regs.begin(), regs.end(), preds[j]) != regs.end())
+				continue;
+			if(!freeRegister(regs, nbRedPebbles, pinned, uses, usesDone, ret))
+				return ret;
+			emit(ret, preds[j], RULE_R1);
+			regs.push_back(preds[j]);
+		}
+		if(!freeRegister(regs, nbRedPebbles, pinned, uses, usesDone, ret))
+			return ret;
+		emit(ret, n, RULE_R3);
+		regs.push_back(n);
+
+		// Predecessors with no use left are deleted at once
+		for(uint32_t j = 0; j < nbPredecessors(d, n); ++j) {
+			node p = preds[j];
+			pinned[p] = false;
+			usesDone[p] += 1;
+			std::vector<node>::iterator r = std::find(regs.begin(), regs.end(), p);
+			if(usesDone[p] == uses[p].size() && r != regs.end()) {
+				emit(ret, p, RULE_R4);
+				regs.erase(r);
+			}
+		}
+		if(nbSuccessors(d, n) == 0) {
+			emit(ret, n, RULE_R2);
+			regs.erase(std::find(regs.begin(), regs.end(), n));
+		}
+	}
+	// Replayed, so that the bound never comes from an invalid schedule
+	simulation_report report = simulateSchedule(d, ret.events, nbRedPebbles);
+	ret.found = isValid(report);
+	ret.cost = ioCost(report);
+	return ret;
+}
+
+greedy_schedule bestGreedySchedule(const dag* d, uint32_t nbRedPebbles, bool shortest, uint32_t maxDates) {
+	greedy_schedule best;
+	best.found = false;
+	for(uint32_t p = 0; p < NB_ORDER_POLICIES; ++p) {
+		greedy_schedule s = greedySchedule(d, nbRedPebbles, (order_policy)p);
+		if(!s.found || s.events.size() > maxDates)
+			continue;
+		bool better = !best.found
+			|| (shortest ? s.events.size() < best.events.size() : s.cost < best.cost);
+		if(better)
+			best = s;
+	}
+	return best;
+}
+
+bool scheduleAssumptions(schedule& events, symbol_table& symbols, expr_vector& assumptions) {
+	for(uint32_t t = 0; t < events.size(); ++t) {
+		if(events[t].n == NO_NODE)
+			continue;
+		if(t >= symbols.nbDates)
+			return false;
+		registered_symbol* event = findRegisteredSymbol(events[t].n, events[t].r, t, symbols);
+		if(event == NULL)
+			return false;
+		assumptions.push_back(event->symbol);
+	}
+	return true;
+}
@@ -0,0 +1,60 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+/*
+ * Greedy schedules, to bracket the search before the solver is called. The
+ * compute order is a list schedule of the DAG, then the registers are
+ * allocated along it with Belady's MIN: when a register is needed, the value
+ * used the furthest in the future leaves it. A value with no use left is
+ * deleted (R4) for free, any other one is stored (R2) and loaded back (R1)
+ * when needed. Outputs are stored as soon as they are computed.
+ *
+ * The schedule follows the game of the liveness engine and of the validator:
+ * its number of dates bounds the deadline, and its loads and stores bound the
+ * I/O cost within a horizon. The interval engine can't spill an input, so it
+ * may not express the schedule; the bound is only used once the solver has
+ * accepted it.
+ */
+
+#ifndef HEURISTIC_H_
+#define HEURISTIC_H_
+
+#include <z3++.h>
+#include "datastruct.h"
+#include "sat-version.h"
+
+using namespace z3;
+
+// Which ready node is computed next
+typedef enum order_policy {
+	ORDER_INDEX,         // lowest node number first
+	ORDER_DEPTH_FIRST,   // the one whose predecessors were computed last
+	ORDER_CRITICAL_PATH  // longest path to an output first
+} order_policy;
+
+#define NB_ORDER_POLICIES 3
+
+typedef struct greedy_schedule {
+	bool found; // false if a node has more predecessors than registers allow
+	order_policy policy;
+	schedule events; // one per date, no idle date
+	uint32_t cost; // R1 + R2
+} greedy_schedule;
+
+extern const char* orderPolicyNames[];
+
+greedy_schedule greedySchedule(const dag* d, uint32_t nbRedPebbles, order_policy policy);
+
+// Best schedule of every policy: the shortest one, or with maxDates, the
+// cheapest one of at most maxDates dates. found is false if none fits.
+greedy_schedule bestGreedySchedule(const dag* d, uint32_t nbRedPebbles, bool shortest, uint32_t maxDates);
+
+// One literal per event of the schedule, to check it or seed the solver's
+// phases with it. Returns false if an event has no symbol in the table,
+// i.e. if the encoding can't express the schedule.
+bool scheduleAssumptions(schedule& events, symbol_table& symbols, expr_vector& assumptions);
+
+#endif /* HEURISTIC_H_ */
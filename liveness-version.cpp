@@ -0,0 +1,158 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+#include "liveness-version.h"
+#include <algorithm>
+
+std::string stateName(const char* state, node n, uint32_t time);
+uint32_t lastComputeDate(run_context& run, node n);
+void buildNodeStates(run_context& run, node n, context& ctx, expr_vector& constraints, symbol_table& symbols,
+		std::vector<expr_vector>& red, std::vector<expr_vector>& blue);
+void livenessPebbleConstraint(run_context& run, std::vector<expr_vector>& red, uint32_t nbRedPebbles, encoding_options& options, context& ctx, expr_vector& constraints);
+
+std::string stateName(const char* state, node n, uint32_t time) {
+	return std::string(state) + "(" + std::to_string(n + 1) + "," + std::to_string(time) + ")";
+}
+
+// ALAP is past the horizon for outputs
+uint32_t lastComputeDate(run_context& run, node n) {
+	return std::min(run.alap[n], run.maxTime - 1);
+}
+
+void buildNodeStates(run_context& run, node n, context& ctx, expr_vector& constraints, symbol_table& symbols,
+		std::vector<expr_vector>& red, std::vector<expr_vector>& blue) {
+	const dag* _dag = run.graph;
+	uint32_t maxTime = run.maxTime;
+	uint32_t t;
+	bool input = (nbPredecessors(_dag, n) == 0);
+
+	expr_vector& redN = red[n];
+	expr_vector& blueN = blue[n];
+	uint32_t last = lastComputeDate(run, n);
+
+	// Initially, inputs are in memory and nothing is in registers
+	constraints.push_back(!redN[0]);
+	constraints.push_back(input ? blueN[0] : !blueN[0]);
+
+	// A non-input can't be loaded, stored or deleted before it is computed
+	uint32_t first = input ? 0 : run.asap[n];
+	for(t = 0; t < maxTime; ++t) {
+		expr load = ctx.bool_val(false);
+		expr store = ctx.bool_val(false);
+		expr compute = ctx.bool_val(false);
+		expr del = ctx.bool_val(false);
+
+		if(t >= first) {
+			load = ruleSymbol(n, RULE_R1, t, ctx, symbols);
+			store = ruleSymbol(n, RULE_R2, t, ctx, symbols);
+			del = ruleSymbol(n, RULE_R4, t, ctx, symbols);
+
+			// R1: in memory, not yet in a register. Outside its window, an
+			// event is false and needs no constraint.
+			if(!load.is_false())
+				constraints.push_back(implies(load, blueN[t] && !redN[t]));
+			// R2, R4: in a register
+			if(!store.is_false())
+				constraints.push_back(implies(store, redN[t]));
+			if(!del.is_false())
+				constraints.push_back(implies(del, redN[t]));
+		}
+		if(!input && t >= run.asap[n] && t <= last) {
+			compute = ruleSymbol(n, RULE_R3, t, ctx, symbols);
+			// R3: every predecessor in a register
+			expr_vector predecessorsInRegisters(ctx);
+			for(uint32_t i = 0; i < nbPredecessors(_dag, n); ++i)
+				predecessorsInRegisters.push_back(red[predecessors(_dag, n)[i]][t]);
+			constraints.push_back(implies(compute, !redN[t] && mk_and(predecessorsInRegisters)));
+		}
+
+		// Frame axioms. R2 spills the value: it leaves the register for memory.
+		// R4 deletes the value for good, as in the validator.
+		constraints.push_back(redN[t+1] == (load || compute || (redN[t] && !store && !del)));
+		constraints.push_back(blueN[t+1] == ((blueN[t] || store) && !del));
+	}
+}
+
+void livenessPebbleConstraint(run_context& run, std::vector<expr_vector>& red, uint32_t nbRedPebbles, encoding_options& options, context& ctx, expr_vector& constraints) {
+	for(uint32_t t = 1; t <= run.maxTime; ++t) {
+		expr_vector inRegisters(ctx);
+		for(uint32_t i = 0; i < red.size(); ++i)
+			inRegisters.push_back(red[i][t]);
+
+		if(options.pebbles != PEBBLES_SUM && options.pebbles != PEBBLES_PREFIX) {
+			expr_vector count = unaryCounter(inRegisters, nbRedPebbles + 1, cardEncoding(options.pebbles), ctx, constraints);
+			boundUnaryCount(count, 0, nbRedPebbles, options, ctx, constraints);
+		} else if(!symbolicRegisters(nbRedPebbles, options)) {
+			// The sum and prefix variants only differ in the interval engine;
+			// here the count is direct, so it's a plain pseudo-Boolean.
+			constraints.push_back(atmost(inRegisters, nbRedPebbles));
+		} else {
+			for(uint32_t k = options.minRegisters; k <= nbRedPebbles; ++k)
+				constraints.push_back(implies(registerGuard(k, ctx), atmost(inRegisters, k)));
+		}
+		flushConstraints(run, constraints);
+	}
+}
+
+void livenessConstraints(run_context& run, uint32_t nbRedPebbles, encoding_options& options, context& ctx, expr_vector& constraints, symbol_table& symbols) {
+	const dag* _dag = run.graph;
+	uint32_t maxTime = run.maxTime;
+	node n;
+	phase_clock clock = startPhase();
+
+	if(maxTime == 0) {
+		constraints.push_back(ctx.bool_val(_dag->nbNodes == _dag->nbInputNodes));
+		flushConstraints(run, constraints);
+		return;
+	}
+
+	// States before each step, and after the last one
+	std::vector<expr_vector> red, blue;
+	for(n = 0; n < _dag->nbNodes; ++n) {
+		red.push_back(expr_vector(ctx));
+		blue.push_back(expr_vector(ctx));
+		for(uint32_t t = 0; t <= maxTime; ++t) {
+			red[n].push_back(ctx.bool_const(stateName("red", n, t).c_str()));
+			blue[n].push_back(ctx.bool_const(stateName("blue", n, t).c_str()));
+		}
+	}
+
+	std::cout << "## Building state variables and frame axioms" << std::endl;
+	for(n = 0; n < _dag->nbNodes; ++n) {
+		buildNodeStates(run, n, ctx, constraints, symbols, red, blue);
+		flushConstraints(run, constraints);
+	}
+	endPhase(run.report, "states", clock);
+
+	std::cout << "## Building computation constraints" << std::endl;
+	for(n = 0; n < _dag->nbNodes; ++n) {
+		if(nbPredecessors(_dag, n) == 0)
+			continue;
+
+		// Computed exactly once
+		expr_vector computeAtT(ctx);
+		for(uint32_t t = run.asap[n]; t <= lastComputeDate(run, n); ++t)
+			computeAtT.push_back(ruleSymbol(n, RULE_R3, t, ctx, symbols));
+		constraints.push_back(mk_or(computeAtT));
+		atMostOne(computeAtT, options.amo, ctx, constraints);
+
+		// Outputs end up in memory
+		if(nbSuccessors(_dag, n) == 0)
+			constraints.push_back(blue[n][maxTime]);
+		flushConstraints(run, constraints);
+	}
+	endPhase(run.report, "computation", clock);
+
+	std::cout << "## Building sequentiality constraints" << std::endl;
+	noTwoSimultaneousNodes(constraints, symbols.symbols, run, options.amo, ctx);
+	flushConstraints(run, constraints);
+	endPhase(run.report, "sequentiality", clock);
+
+	std::cout << "## Building architectural constraints" << std::endl;
+	livenessPebbleConstraint(run, red, nbRedPebbles, options, ctx, constraints);
+	flushConstraints(run, constraints);
+	endPhase(run.report, "architectural", clock);
+}
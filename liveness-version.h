@@ -0,0 +1,35 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+/*
+ * Second encoding engine. Instead of expressing each dependence as a
+ * disjunction over every window of time where the value could have been
+ * loaded or computed and not spilled since, this one keeps an explicit state
+ * for each node n and date t:
+ *   red(n, t)  - the value is in a register before step t
+ *   blue(n, t) - the value is in memory before step t
+ * Frame axioms tie the states at t+1 to the states and the R1-R4 events at t,
+ * so that computing a node at t only requires red(p, t) for its predecessors.
+ * The encoding is O(N x T) in variables and constraints.
+ *
+ * It doesn't play quite the same game as the interval engine, so the two can
+ * disagree on the same cell, either way. Here the game is the one the
+ * simulator replays: R4 is optional, needs the value in a register, and
+ * removes it from memory as well. The interval engine keeps its original
+ * rules: every predecessor of a computed node must be deleted by an R4 later
+ * on (P5), which takes up dates, and the register count is the running sum
+ * of the events, whether or not an R2 or R4 applies to a value in a
+ * register. Compare bounds within one engine, not across them.
+ */
+
+#ifndef LIVENESS_VERSION_H_
+#define LIVENESS_VERSION_H_
+
+#include "sat-version.h"
+
+void livenessConstraints(run_context& run, uint32_t nbRedPebbles, encoding_options& options, context& ctx, expr_vector& constraints, symbol_table& symbols);
+
+#endif /* LIVENESS_VERSION_H_ */
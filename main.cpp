@@ -6,867 +6,803 @@
 
 #include <z3++.h>
 #include <vector>
+#include <chrono>
+#include <cstring>
+#include <getopt.h>
 
 #include "datastruct.h"
 #include "sat-version.h"
+#include "search.h"
+#include "portfolio.h"
+#include "sweep.h"
+#include "dagio.h"
+#include "builtin-dags.h"
+#include "generators.h"
+#include "heuristic.h"
+#include "simulator.h"
+#include "reduce.h"
+#include "report.h"
+#include "export.h"
+#include "pipeline.h"
+#include <thread>
 
 using namespace z3;
 
-int main(int argc, char* argv[])
-{
+const char* resultName(check_result result);
+
+void usage(char* name) {
+	std::cout << "Usage: " << name << " [options] [io_budget] [nb_registers]" << std::endl;
+	std::cout << "Options:" << std::endl;
+	std::cout << "  --engine=interval|liveness  constraint formulation (default: interval). The rules differ:" << std::endl;
+	std::cout << "                         interval forces a delete of every predecessor after each compute;" << std::endl;
+	std::cout << "                         liveness has optional deletes, which also clear memory, as the" << std::endl;
+	std::cout << "                         schedule check does. Bounds from the two engines can disagree" << std::endl;
+	std::cout << "  --pebbles=ENC          encoding of the red pebble limit: sum (default), prefix," << std::endl;
+	std::cout << "                         or pure CNF seqcounter, totalizer, sortnet" << std::endl;
+	std::cout << "  --amo=ENC              at-most-one encoding: pb (default), or pure CNF pairwise, ladder, commander" << std::endl;
+	std::cout << "  --no-interval-cache    rebuild every interval disjunction from scratch (interval engine)" << std::endl;
+	std::cout << "  --no-event-windows     create R1, R2 and R4 symbols over the whole horizon (the interval" << std::endl;
+	std::cout << "                         engine always does for R2 and R4)" << std::endl;
+	std::cout << "  --no-symmetry-breaking don't order the compute dates of symmetric nodes" << std::endl;
+	std::cout << "  --no-ordering-lemmas   don't add the redundant constraints between nodes on a path" << std::endl;
+	std::cout << "  --no-upper-bound       don't start from a greedy schedule: it bounds --search, and is tried" << std::endl;
+	std::cout << "                         first by the solver, whose phases then follow it" << std::endl;
+	std::cout << "  --search=linear|binary build once for io_budget, then search the tightest budget" << std::endl;
+	std::cout << "                         on the same solver, with the dates guarded by assumptions" << std::endl;
+	std::cout << "  --min-budget=N         smallest budget tried by --search (default: 0)" << std::endl;
+	std::cout << "  --horizon=H            schedule within H dates; io_budget then caps the number of" << std::endl;
+	std::cout << "                         loads and stores (R1 + R2) instead of being the deadline," << std::endl;
+	std::cout << "                         and --search looks for the smallest such cap" << std::endl;
+	std::cout << "  --minimise-io          with --horizon, minimise the number of loads and stores" << std::endl;
+	std::cout << "                         directly with the optimiser" << std::endl;
+	std::cout << "  --registers-from=N     build once with a symbolic register count, then find the" << std::endl;
+	std::cout << "                         smallest count in [N, nb_registers] on the same solver" << std::endl;
+	std::cout << "  --portfolio=N          solve with N threads, each with its own configuration and" << std::endl;
+	std::cout << "                         encoding variant; the first one to conclude stops the others" << std::endl;
+	std::cout << "  --sweep                io_budget and nb_registers are ranges MIN:MAX; solve the grid" << std::endl;
+	std::cout << "                         on a thread pool, infer what monotonicity gives, and print" << std::endl;
+	std::cout << "                         the frontier as CSV" << std::endl;
+	std::cout << "  --threads=N            threads of --sweep (default: one per core)" << std::endl;
+	std::cout << "  --reduce               collapse chains and drop output twins before encoding; unsat" << std::endl;
+	std::cout << "                         holds for the original DAG, a schedule is lifted back and checked" << std::endl;
+	std::cout << "  --compare-pebbles      build and solve with every pebble encoding, report size and time" << std::endl;
+	std::cout << "  --dag=FILE             load the DAG from a text edge list or a binary CSR file" << std::endl;
+	std::cout << "                         (formats in dagio.h)" << std::endl;
+	std::cout << "  --builtin=NAME         use a DAG compiled into the program (default: " << DEFAULT_BUILTIN_DAG << "), one of:" << std::endl;
+	std::cout << "                         ";
+	listBuiltinDAGs(std::cout);
+	std::cout << "  --generate=SPEC        use a generated DAG, from one of the families (see generators.h):" << std::endl;
+	std::cout << "                         ";
+	listDAGFamilies(std::cout);
+	std::cout << "  --convert=FILE         write the DAG as a binary CSR file and exit" << std::endl;
+	std::cout << "  --export=FILE          write the constraints to FILE (or a named pipe) as they are built," << std::endl;
+	std::cout << "                         instead of solving them" << std::endl;
+	std::cout << "  --export-format=FMT    smt2 (default), or dimacs for the pure-Boolean encodings" << std::endl;
+	std::cout << "  --pipeline=P           preprocess with Z3 tactics before solving: a preset (simplify, sat, smt, pb)" << std::endl;
+	std::cout << "                         or tactic[:param=value]*,...[,sat|smt], e.g. simplify,solve-eqs,smt" << std::endl;
+	std::cout << "  --report=FILE          append one JSON record of the run to FILE (- for stdout): wall" << std::endl;
+	std::cout << "                         and CPU time and peak RSS of each phase, formula size, outcome," << std::endl;
+	std::cout << "                         and the solver's statistics" << std::endl;
+	exit(1);
+}
 
-	if(argc < 3) {
-		std::cout << "Usage: " << argv[0] << " [io_budget] [nb_registers]" << std::endl;
-		std::cout << "See main.cpp to change the DAG" << std::endl;
-		exit(1);
+bool parsePebbleEncoding(const char* name, pebble_encoding& encoding) {
+	for(uint32_t i = 0; i <= PEBBLES_SORTING_NETWORK; ++i) {
+		if(strcmp(name, pebbleEncodingNames[i]) == 0) {
+			encoding = (pebble_encoding)i;
+			return true;
+		}
 	}
+	return false;
+}
 
-	context ctx;
-	set_param("parallel.enable", true);
-
-	/*
-	 * These examples come straight from last year's internship.
-	 */
-
-#define __TEST_FFT4
-
-#ifdef __TEST_SAMPLE14
-#define MAX_DEPS 2
-#define NB_NODES 14
-#define TEST_NAME "sample14"
-    uint32_t deps[NB_NODES][MAX_DEPS] = {
-        {0, 0},   // 1   S
-        {0, 0},   // 2   A
-        {0, 0},   // 3   B1
-        {0, 0},   // 4   B2
-        {0, 0},   // 5   B3
-        {0, 0},   // 6   B4
-        {2, 3},   // 7   AB1
-        {2, 4},   // 8   AB2
-        {2, 5},   // 9   AB3
-        {2, 6},   // 10  AB4
-        {1, 7},   // 11  S + AB1
-        {8, 11},  // 12  S + AB1 + AB2
-        {9, 12},  // 13  S + AB1 + AB2 + AB3
-        {10, 13}  // 14  S + AB1 + AB2 + AB3 + AB4
-    };
-#endif
-
-#ifdef __TEST_SAMPLE3
-#define MAX_DEPS 2
-#define NB_NODES 3
-#define TEST_NAME "sample3"
-    uint32_t deps[NB_NODES][MAX_DEPS] = {
-        {0, 0},   // 1   A
-        {0, 0},   // 2   B
-        {1, 2},   // 3   A + B
-    };
-#endif
-
-#ifdef __TEST_SAMPLE5
-#define MAX_DEPS 2
-#define NB_NODES 5
-#define TEST_NAME "sample5"
-    uint32_t deps[NB_NODES][MAX_DEPS] = {
-        {0, 0},   // 1   A
-        {0, 0},   // 2   B
-        {1, 2},   // 3   A + B
-        {3, 2},   // 4   A + 2B
-        {1, 3}    // 5   2A + B
-    };
-#endif
-
-#ifdef __TEST_SAMPLE6
-#define MAX_DEPS 2
-#define NB_NODES 6
-#define TEST_NAME "sample6"
-    uint32_t deps[NB_NODES][MAX_DEPS] = {
-        {0, 0},   // 1   A
-        {0, 0},   // 2   B
-        {1, 2},   // 3   A + B
-        {3, 2},   // 4   A + 2B
-        {1, 3},   // 5   2A + B
-        {4, 5}    // 6   3A + 3B
-    };
-#endif
-
-
-#ifdef __TEST_SAMPLE11
-#define MAX_DEPS 2
-#define NB_NODES 11
-#define TEST_NAME "sample11"
-    uint32_t deps[NB_NODES][MAX_DEPS] = {
-        {0, 0},   // 1   S
-        {0, 0},   // 2   A
-        {0, 0},   // 3   B1
-        {0, 0},   // 4   B2
-        {0, 0},   // 5   B3
-        {2, 3},   // 6   AB1
-        {2, 4},   // 7   AB2
-        {2, 5},   // 8   AB3
-        {1, 6},   // 9   S + AB1
-        {9, 7},   // 10  S + AB1 + AB2
-        {8, 10}   // 11  S + AB1 + AB2 + AB3
-    };
-
-#endif
-
-#ifdef __TEST_FFT8
-    // FFT-8
-#define MAX_DEPS 2
-#define NB_NODES 32
-#define TEST_NAME "fft8"
-    uint32_t deps[NB_NODES][MAX_DEPS] = {
-        { 0, 0}, // i1
-        { 0, 0}, // i2
-        { 0, 0}, // i3
-        { 0, 0}, // i4
-        { 0, 0}, // i5
-        { 0, 0}, // i6
-        { 0, 0}, // i7
-        { 0, 0}, // i8
-
-        { 1, 2}, // 09
-        { 1, 2}, // 10
-        { 3, 4}, // 11
-        { 3, 4}, // 12
-        { 5, 6}, // 13
-        { 5, 6}, // 14
-        { 7, 8}, // 15
-        { 7, 8}, // 16
-
-        {9, 11}, // 17
-        {10,12}, // 18
-        {9, 11}, // 19
-        {10,12}, // 20
-        {13,15}, // 21
-        {14,16}, // 22
-        {13,15}, // 23
-        {14,16}, // 24
-
-        {17,21}, // 25
-        {18,22}, // 26
-        {19,23}, // 27
-        {20,24}, // 28
-        {21,17}, // 29
-        {22,18}, // 30
-        {23,19}, // 31
-        {24,20}  // 32
-    };
-#endif
-
-#ifdef __TEST_FFT4
-    // FFT-4
-#define MAX_DEPS 2
-#define NB_NODES 12
-#define TEST_NAME "fft4"
-    uint32_t deps[NB_NODES][MAX_DEPS] = {
-        {0, 0},
-        {0, 0},
-        {0, 0},
-        {0, 0},
-
-        {1, 2},
-        {1, 2},
-        {3, 4},
-        {3, 4},
-
-        {5, 7},
-        {6, 8},
-        {5, 7},
-        {6, 8}
+// "MIN:MAX", or a single value
+bool parseRange(const char* text, sweep_range& range) {
+	char* end;
+	range.min = (uint32_t)strtoul(text, &end, 10);
+	range.max = range.min;
+	if(*end == ':')
+		range.max = (uint32_t)strtoul(end + 1, &end, 10);
+	return *end == '\0' && range.min <= range.max;
+}
 
-    };
+bool parseEngine(const char* name, encoding_engine& engine) {
+	if(strcmp(name, "interval") == 0)
+		engine = ENGINE_INTERVAL;
+	else if(strcmp(name, "liveness") == 0)
+		engine = ENGINE_LIVENESS;
+	else
+		return false;
+	return true;
+}
 
-#endif
-
-#ifdef __TEST_JACOBI2D
-    // Jacobi-2D
-#define MAX_DEPS 7
-#define NB_NODES 20
-#define TEST_NAME "jacobi2d"
-    uint32_t deps[NB_NODES][MAX_DEPS] = {
-        {0, 0, 0, 0, 0, 0, 0},  // c1
-        {0, 0, 0, 0, 0, 0, 0},  // c2
-
-
-        {0, 0, 0, 0, 0, 0, 0},  // A[0, 0] = 3
-        {0, 0, 0, 0, 0, 0, 0},  // A[0, 1] = 4
-        {0, 0, 0, 0, 0, 0, 0},  // A[0, 2] = 5
-        {0, 0, 0, 0, 0, 0, 0},  // A[1, 0] = 6
-        {0, 0, 0, 0, 0, 0, 0},  // A[1, 1] = 7
-        {0, 0, 0, 0, 0, 0, 0},  // A[0, 0] = 8
-        {0, 0, 0, 0, 0, 0, 0},  // A[2, 0] = 9
-        {0, 0, 0, 0, 0, 0, 0},  // A[2, 1] = 10
-        {0, 0, 0, 0, 0, 0, 0},  // A[2, 2] = 11
-
-        {1, 2, 3, 4, 6, 0, 0},  // B[0, 0]
-        {1, 2, 3, 4, 5, 7, 0},  // B[0, 1]
-        {1, 2, 4, 5, 8, 0, 0},  // B[0, 2]
-        {1, 2, 3, 6, 7, 9, 0},  // B[1, 0]
-        {1, 2, 4, 6, 7, 8, 10},  // B[1, 1]
-        {1, 2, 5, 7, 8, 11, 0},  // B[1, 2]
-        {1, 2, 6, 8, 9, 0, 0},  // B[2, 0]
-        {1, 2, 7, 9, 10, 11, 0},  // B[2, 1]
-        {1, 2, 8, 10, 11, 0, 0}  // B[2, 2]
+bool parseAmoEncoding(const char* name, amo_encoding& encoding) {
+	for(uint32_t i = 0; i <= AMO_COMMANDER; ++i) {
+		if(strcmp(name, amoEncodingNames[i]) == 0) {
+			encoding = (amo_encoding)i;
+			return true;
+		}
+	}
+	return false;
+}
 
-    };
-#endif
-
-#ifdef __TEST_MATMULT4
-    // Matmult
-#define MAX_DEPS 2
-#define NB_NODES 176
-#define TEST_NAME "matmult4"
-    uint32_t deps[NB_NODES][MAX_DEPS] = {
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {1,17},
-        {33,34},
-        {2,21},
-        {35,36},
-        {3,25},
-        {37,38},
-        {4,29},
-        {39,40},
-        {0,0},
-        {1,18},
-        {42,43},
-        {2,22},
-        {44,45},
-        {3,26},
-        {46,47},
-        {4,30},
-        {48,49},
-        {0,0},
-        {1,19},
-        {51,52},
-        {2,23},
-        {53,54},
-        {3,27},
-        {55,56},
-        {4,31},
-        {57,58},
-        {0,0},
-        {1,20},
-        {60,61},
-        {2,24},
-        {62,63},
-        {3,28},
-        {64,65},
-        {4,32},
-        {66,67},
-        {0,0},
-        {5,17},
-        {69,70},
-        {6,21},
-        {71,72},
-        {7,25},
-        {73,74},
-        {8,29},
-        {75,76},
-        {0,0},
-        {5,18},
-        {78,79},
-        {6,22},
-        {80,81},
-        {7,26},
-        {82,83},
-        {8,30},
-        {84,85},
-        {0,0},
-        {5,19},
-        {87,88},
-        {6,23},
-        {89,90},
-        {7,27},
-        {91,92},
-        {8,31},
-        {93,94},
-        {0,0},
-        {5,20},
-        {96,97},
-        {6,24},
-        {98,99},
-        {7,28},
-        {100,101},
-        {8,32},
-        {102,103},
-        {0,0},
-        {9,17},
-        {105,106},
-        {10,21},
-        {107,108},
-        {11,25},
-        {109,110},
-        {12,29},
-        {111,112},
-        {0,0},
-        {9,18},
-        {114,115},
-        {10,22},
-        {116,117},
-        {11,26},
-        {118,119},
-        {12,30},
-        {120,121},
-        {0,0},
-        {9,19},
-        {123,124},
-        {10,23},
-        {125,126},
-        {11,27},
-        {127,128},
-        {12,31},
-        {129,130},
-        {0,0},
-        {9,20},
-        {132,133},
-        {10,24},
-        {134,135},
-        {11,28},
-        {136,137},
-        {12,32},
-        {138,139},
-        {0,0},
-        {13,17},
-        {141,142},
-        {14,21},
-        {143,144},
-        {15,25},
-        {145,146},
-        {16,29},
-        {147,148},
-        {0,0},
-        {13,18},
-        {150,151},
-        {14,22},
-        {152,153},
-        {15,26},
-        {154,155},
-        {16,30},
-        {156,157},
-        {0,0},
-        {13,19},
-        {159,160},
-        {14,23},
-        {161,162},
-        {15,27},
-        {163,164},
-        {16,31},
-        {165,166},
-        {0,0},
-        {13,20},
-        {168,169},
-        {14,24},
-        {170,171},
-        {15,28},
-        {172,173},
-        {16,32},
-        {174,175}
-    };
-#endif
-
-#ifdef __TEST_MATMULT3
-#define NB_NODES 81
-#define MAX_DEPS 2
-#define TEST_NAME "matmult3"
-    uint32_t deps[NB_NODES][MAX_DEPS] = {
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {1,10},
-        {19,20},
-        {2,13},
-        {21,22},
-        {3,16},
-        {23,24},
-        {0,0},
-        {1,11},
-        {26,27},
-        {2,14},
-        {28,29},
-        {3,17},
-        {30,31},
-        {0,0},
-        {1,12},
-        {33,34},
-        {2,15},
-        {35,36},
-        {3,18},
-        {37,38},
-        {0,0},
-        {4,10},
-        {40,41},
-        {5,13},
-        {42,43},
-        {6,16},
-        {44,45},
-        {0,0},
-        {4,11},
-        {47,48},
-        {5,14},
-        {49,50},
-        {6,17},
-        {51,52},
-        {0,0},
-        {4,12},
-        {54,55},
-        {5,15},
-        {56,57},
-        {6,18},
-        {58,59},
-        {0,0},
-        {7,10},
-        {61,62},
-        {8,13},
-        {63,64},
-        {9,16},
-        {65,66},
-        {0,0},
-        {7,11},
-        {68,69},
-        {8,14},
-        {70,71},
-        {9,17},
-        {72,73},
-        {0,0},
-        {7,12},
-        {75,76},
-        {8,15},
-        {77,78},
-        {9,18},
-        {79,80}
-    };
+// Pure-CNF encodings go to the SAT core
+solver makeSolver(context& ctx, encoding_options& options) {
+	if(isPureBoolean(options))
+		return solver(ctx, "QF_FD");
+	return solver(ctx);
+}
 
-#endif
-
-#ifdef __TEST_MATMULT2
-#define NB_NODES 28
-#define MAX_DEPS 2
-#define TEST_NAME "matmult2"
-    uint32_t deps[NB_NODES][MAX_DEPS] = {
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {1,5},
-        {9,10},
-        {2,7},
-        {11,12},
-        {0,0},
-        {1,6},
-        {14,15},
-        {2,8},
-        {16,17},
-        {0,0},
-        {3,5},
-        {19,20},
-        {4,7},
-        {21,22},
-        {0,0},
-        {3,6},
-        {24,25},
-        {4,8},
-        {26,27}
-    };
+// Build the constraints in a fresh context with the given options, solve them,
+// and report the formula size and the time spent.
+void reportEncoding(const dag* programDag, uint32_t budget, uint32_t nbRedPebbles, encoding_options& options, const char* name) {
+	context ctx;
+	expr_vector constraints(ctx);
+	symbol_table symbols;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	dagToConstraints(programDag, nbRedPebbles, budget, options, ctx, constraints, symbols);
+	std::chrono::steady_clock::time_point built = std::chrono::steady_clock::now();
+
+	uint64_t size = formulaSize(constraints);
+
+	solver s = makeSolver(ctx, options);
+	s.add(mk_and(constraints).simplify());
+	check_result solve_result = s.check();
+	std::chrono::steady_clock::time_point solved = std::chrono::steady_clock::now();
+
+	std::cout << "# Encoding " << name << ": " << std::to_string(constraints.size()) << " constraints, "
+			<< std::to_string(size) << " terms, "
+			<< std::to_string(symbols.symbols.size()) << " event symbols, "
+			<< "built in " << std::chrono::duration<double>(built - start).count() << " s, "
+			<< "solved in " << std::chrono::duration<double>(solved - built).count() << " s: "
+			<< resultName(solve_result) << std::endl;
+}
 
-#endif
-
-#ifdef __TEST_MATMULT2_SIMPLE
-#define NB_NODES 24
-#define MAX_DEPS 2
-#define TEST_NAME "matmult2_simple"
-    uint32_t deps[NB_NODES][MAX_DEPS] = {
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {1,5},
-        {0,9},
-        {2,7},
-        {10,11},
-        {1,6},
-        {0,13},
-        {2,8},
-        {14,15},
-        {3,5},
-        {0,17},
-        {4,7},
-        {18,19},
-        {3,6},
-        {0,21},
-        {4,8},
-        {22,23}
-    };
+// Print the schedule found in the model, and replay it to check its validity.
+// With a reduction, the model schedules the reduced DAG: it is lifted back to
+// the original DAG before the check.
+simulation_report checkSchedule(const dag* _dag, model& result, uint32_t maxTime, uint32_t nbRedPebbles, symbol_table& symbols, dag_reduction* reduction) {
+	// Time-indexed schedule, straight from the declarations of the model
+	schedule sched = decodeModel(result, maxTime, symbols);
+
+	// print by schedule
+	for(uint32_t t = 0; t < maxTime; t++) {
+		if(sched[t].n != NO_NODE)
+			std::cout << findRegisteredSymbol(sched[t].n, sched[t].r, t, symbols)->symbol.to_string() << " ";
+	}
+	std::cout << std::endl;
+
+	if(reduction != NULL) {
+		sched = liftSchedule(*reduction, sched);
+		_dag = reduction->original;
+		maxTime = sched.size();
+		std::cout << "# Lifted to the original DAG, " << std::to_string(maxTime)
+				<< " dates; the reduction is a relaxation, so this may not fit the registers" << std::endl;
+		for(uint32_t t = 0; t < maxTime; t++)
+			std::cout << symbolName(sched[t].n, sched[t].r, t) << " ";
+		std::cout << std::endl;
+	}
 
-#endif
-
-#ifdef __TEST_MATMULT3_SIMPLE
-#define NB_NODES 72
-#define MAX_DEPS 2
-#define TEST_NAME "matmult3_simple"
-    uint32_t deps[NB_NODES][MAX_DEPS] = {
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {0,0},
-        {1,10},
-        {0,19},
-        {2,13},
-        {20,21},
-        {3,16},
-        {22,23},
-        {1,11},
-        {0,25},
-        {2,14},
-        {26,27},
-        {3,17},
-        {28,29},
-        {1,12},
-        {0,31},
-        {2,15},
-        {32,33},
-        {3,18},
-        {34,35},
-        {4,10},
-        {0,37},
-        {5,13},
-        {38,39},
-        {6,16},
-        {40,41},
-        {4,11},
-        {0,43},
-        {5,14},
-        {44,45},
-        {6,17},
-        {46,47},
-        {4,12},
-        {0,49},
-        {5,15},
-        {50,51},
-        {6,18},
-        {52,53},
-        {7,10},
-        {0,55},
-        {8,13},
-        {56,57},
-        {9,16},
-        {58,59},
-        {7,11},
-        {0,61},
-        {8,14},
-        {62,63},
-        {9,17},
-        {64,65},
-        {7,12},
-        {0,67},
-        {8,15},
-        {68,69},
-        {9,18},
-        {70,71}
-    };
+	std::cout << "# Checking for the schedule's validity" << std::endl;
+	simulation_report report = simulateSchedule(_dag, sched, nbRedPebbles);
+	if(isValid(report)) {
+		std::cout << "Schedule VALID :) I/O cost: " << std::to_string(ioCost(report))
+				<< ", at most " << std::to_string(report.peakRegisters) << " registers used" << std::endl;
+	} else {
+		std::cout << "INVALID: " << violationMessage(report.firstViolation) << ", node "
+				<< std::to_string(report.violationNode + 1);
+		if(report.violationDate != NO_DATE)
+			std::cout << " at date " << std::to_string(report.violationDate);
+		std::cout << std::endl;
+	}
+	return report;
+}
 
-#endif
-
-#ifdef __TEST_JACOBI2D_EXT
-#define NB_NODES 72
-#define MAX_DEPS 2
-#define TEST_NAME "jacobi2d-ext"
-    uint32_t deps[NB_NODES][MAX_DEPS] = {
-        {0,   0},  // c1
-        {0,   0},  // c2
-        {0,   0},  // A[0, 0] = 3
-        {0,   0},  // A[0, 1] = 4
-        {0,   0},  // A[0, 2] = 5
-        {0,   0},  // A[1, 0] = 6
-        {0,   0},  // A[1, 1] = 7
-        {0,   0},  // A[1, 2] = 8
-        {0,   0},  // A[2, 0] = 9
-        {0,   0},  // A[2, 1] = 10
-        {0,   0},  // A[2, 2] = 11
-        {1,   4},  // c1 * A[0,1]
-        {1,   6},  // c1 * A[1,0]
-        {12, 13},  // c1(A[0,1] + A[1, 0])
-        {2,   3},  // c2 * A[0,0]
-        {14, 15},  // B[0, 0]
-        {1,   3},
-        {1,   5},
-        {17, 18},
-        {1,   7},
-        {19, 20},
-        {2,   4},
-        {21, 22}, // B[0,1]
-        {1,   4},
-        {1,   8},
-        {24, 25},
-        {2,   5},
-        {26, 27}, // B[0, 2]
-        {1,   3},
-        {1,   7},
-        {29, 30},
-        {1,   9},
-        {31, 32},
-        {2,   6},
-        {33, 34}, // B[1, 0]
-        {1,   4},
-        {1,   6},
-        {36, 37},
-        {1,   8},
-        {38, 39},
-        {1,  10},
-        {40, 41},
-        {2,   7},
-        {42, 43}, // B[1, 1]
-        {1,   5},
-        {1,   7},
-        {45, 46},
-        {1,  11},
-        {47, 48},
-        {2,   8},
-        {49, 50}, // B[1, 2]
-        {1,   2},
-        {1,   6},
-        {52, 53},
-        {1,   8},
-        {54, 55},
-        {1,   9},
-        {56, 57},
-        {2,   9},
-        {58, 59}, // B[2, 0]
-        {1,   7},
-        {1,   9},
-        {61, 62},
-        {1,  11},
-        {63, 64},
-        {2,  10},
-        {65, 66}, // B[2, 1]
-        {1,   8},
-        {1,  10},
-        {68, 69},
-        {2,  11},
-        {70, 71} // B[2, 2]
-    };
-#endif
+const char* resultName(check_result result) {
+	return result == sat ? "sat" : (result == unsat ? "unsat" : "unknown");
+}
 
-    std::cout << "# This is SMT-LB-IO for " << TEST_NAME << std::endl;
+void reportSchedule(run_report& report, simulation_report& replay) {
+	reportField(report, "schedule", std::string(isValid(replay) ? "valid" : violationMessage(replay.firstViolation)));
+	reportField(report, "schedule_io_cost", (uint64_t)ioCost(replay));
+	reportField(report, "schedule_peak_registers", (uint64_t)replay.peakRegisters);
+}
 
-    std::cout << "# Creating DAG from matrix representation" << std::endl;
-    node* dagNodes = matrixToNodes(deps, (uint32_t)NB_NODES);
-    dag* programDag = createDAGStructure(dagNodes, NB_NODES);
+void reportSearch(run_report& report, budget_search_result& found) {
+	reportField(report, "checks", (uint64_t)found.nbChecks);
+	if(found.tightestUnsat != NO_BUDGET)
+		reportField(report, "tightest_unsat", (uint64_t)found.tightestUnsat);
+	if(found.tightestSat != NO_BUDGET)
+		reportField(report, "tightest_sat", (uint64_t)found.tightestSat);
+}
 
-    std::cout << "# Creating constraints from the DAG" << std::endl;
-    expr_vector constraints(ctx);
+// The record is only written when asked for
+void emitReport(run_report& report, const char* path) {
+	if(path != NULL)
+		appendJSONReport(report, path);
+}
 
-    symbol_list symbols;
+int main(int argc, char* argv[])
+{
+	encoding_options options;
+	options.engine = ENGINE_INTERVAL;
+	options.pebbles = PEBBLES_SUM;
+	options.amo = AMO_PB;
+	options.intervalCache = true;
+	options.eventWindows = true;
+	options.symmetryBreaking = true;
+	options.orderingLemmas = true;
+	options.ioBudget = NO_IO_BUDGET;
+	options.minRegisters = NO_SYMBOLIC_REGISTERS;
+	bool comparePebbles = false;
+	bool minimiseIO = false;
+	bool horizonGiven = false;
+	uint32_t givenHorizon = 0;
+	uint32_t portfolioThreads = 0;
+	const char* dagFile = NULL;
+	const char* builtinName = DEFAULT_BUILTIN_DAG;
+	const char* generateSpec = NULL;
+	const char* convertTo = NULL;
+	const char* reportPath = NULL;
+	const char* exportPath = NULL;
+	export_format exportFormat = EXPORT_SMT2;
+	const char* pipelineText = NULL;
+	tactic_pipeline pipeline;
+	bool sweep = false;
+	bool reduce = false;
+	bool upperBound = true;
+	uint32_t sweepThreads = std::thread::hardware_concurrency();
+	search_strategy strategy = SEARCH_NONE;
+	uint32_t minBudget = 0;
+
+	static struct option longOptions[] = {
+		{ "engine", required_argument, 0, 'e' },
+		{ "pebbles", required_argument, 0, 'p' },
+		{ "amo", required_argument, 0, 'a' },
+		{ "no-interval-cache", no_argument, 0, 'i' },
+		{ "no-event-windows", no_argument, 0, 'w' },
+		{ "no-symmetry-breaking", no_argument, 0, 'y' },
+		{ "no-ordering-lemmas", no_argument, 0, 'l' },
+		{ "no-upper-bound", no_argument, 0, 'u' },
+		{ "compare-pebbles", no_argument, 0, 'c' },
+		{ "search", required_argument, 0, 's' },
+		{ "min-budget", required_argument, 0, 'm' },
+		{ "horizon", required_argument, 0, 'h' },
+		{ "minimise-io", no_argument, 0, 'o' },
+		{ "portfolio", required_argument, 0, 'P' },
+		{ "sweep", no_argument, 0, 'S' },
+		{ "registers-from", required_argument, 0, 'r' },
+		{ "dag", required_argument, 0, 'd' },
+		{ "builtin", required_argument, 0, 'b' },
+		{ "generate", required_argument, 0, 'g' },
+		{ "convert", required_argument, 0, 'C' },
+		{ "threads", required_argument, 0, 't' },
+		{ "reduce", no_argument, 0, 'R' },
+		{ "report", required_argument, 0, 'j' },
+		{ "export", required_argument, 0, 'x' },
+		{ "export-format", required_argument, 0, 'f' },
+		{ "pipeline", required_argument, 0, 'T' },
+		{ 0, 0, 0, 0 }
+	};
+
+	int opt;
+	while((opt = getopt_long(argc, argv, "", longOptions, NULL)) != -1) {
+		switch(opt) {
+		case 'p':
+			if(!parsePebbleEncoding(optarg, options.pebbles))
+				usage(argv[0]);
+			break;
+		case 'e':
+			if(!parseEngine(optarg, options.engine))
+				usage(argv[0]);
+			break;
+		case 'a':
+			if(!parseAmoEncoding(optarg, options.amo))
+				usage(argv[0]);
+			break;
+		case 'i':
+			options.intervalCache = false;
+			break;
+		case 'w':
+			options.eventWindows = false;
+			break;
+		case 'y':
+			options.symmetryBreaking = false;
+			break;
+		case 'l':
+			options.orderingLemmas = false;
+			break;
+		case 'u':
+			upperBound = false;
+			break;
+		case 'c':
+			comparePebbles = true;
+			break;
+		case 's':
+			if(strcmp(optarg, "linear") == 0)
+				strategy = SEARCH_LINEAR;
+			else if(strcmp(optarg, "binary") == 0)
+				strategy = SEARCH_BINARY;
+			else
+				usage(argv[0]);
+			break;
+		case 'm':
+			minBudget = (uint32_t)atoi(optarg);
+			break;
+		case 'h':
+			horizonGiven = true;
+			givenHorizon = (uint32_t)atoi(optarg);
+			break;
+		case 'o':
+			minimiseIO = true;
+			break;
+		case 'd':
+			dagFile = optarg;
+			break;
+		case 'b':
+			builtinName = optarg;
+			break;
+		case 'g':
+			generateSpec = optarg;
+			break;
+		case 'C':
+			convertTo = optarg;
+			break;
+		case 'r':
+			options.minRegisters = (uint32_t)atoi(optarg);
+			break;
+		case 'S':
+			sweep = true;
+			break;
+		case 'R':
+			reduce = true;
+			break;
+		case 'j':
+			reportPath = optarg;
+			break;
+		case 'x':
+			exportPath = optarg;
+			break;
+		case 'f':
+			if(strcmp(optarg, "smt2") == 0)
+				exportFormat = EXPORT_SMT2;
+			else if(strcmp(optarg, "dimacs") == 0)
+				exportFormat = EXPORT_DIMACS;
+			else
+				usage(argv[0]);
+			break;
+		case 'T':
+			pipelineText = optarg;
+			if(!parsePipeline(optarg, pipeline)) {
+				std::cerr << "Can't read the pipeline " << optarg << ", give tactic[:param=value]*,...[,sat|smt]"
+						<< " or one of: ";
+				listPipelinePresets(std::cerr);
+				return 1;
+			}
+			break;
+		case 't':
+			sweepThreads = (uint32_t)atoi(optarg);
+			if(sweepThreads == 0)
+				usage(argv[0]);
+			break;
+		case 'P':
+			portfolioThreads = (uint32_t)atoi(optarg);
+			if(portfolioThreads == 0)
+				usage(argv[0]);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
 
+	if(argc - optind < 2 && convertTo == NULL)
+		usage(argv[0]);
+	// The optimiser needs a horizon to minimise the I/O within, and has no budget to search
+	if(minimiseIO && (!horizonGiven || strategy != SEARCH_NONE))
+		usage(argv[0]);
+	// The portfolio is a plain solve
+	if(portfolioThreads > 0 && (minimiseIO || strategy != SEARCH_NONE))
+		usage(argv[0]);
+	bool registerRange = (options.minRegisters != NO_SYMBOLIC_REGISTERS);
+	if(registerRange && (portfolioThreads > 0 || minimiseIO || strategy != SEARCH_NONE || comparePebbles))
+		usage(argv[0]);
+	if(sweep && (registerRange || portfolioThreads > 0 || minimiseIO || strategy != SEARCH_NONE || comparePebbles))
+		usage(argv[0]);
+	// The offsets of a reduction only apply to one given horizon and budget
+	if(reduce && (sweep || registerRange || minimiseIO || strategy != SEARCH_NONE || comparePebbles))
+		usage(argv[0]);
+	// One record is one encoding solved on one solver
+	if(reportPath != NULL && (sweep || portfolioThreads > 0 || comparePebbles || convertTo != NULL))
+		usage(argv[0]);
+	// The export is one encoding for one horizon and register count, unsolved
+	if(exportPath != NULL && (sweep || registerRange || portfolioThreads > 0 || minimiseIO || strategy != SEARCH_NONE
+			|| comparePebbles || reduce))
+		usage(argv[0]);
+	// The tactics may eliminate the symbols the searches and the greedy
+	// schedule assume, and the sweep and the portfolio build their own solvers
+	if(pipelineText != NULL && (sweep || registerRange || portfolioThreads > 0 || minimiseIO || strategy != SEARCH_NONE
+			|| comparePebbles || exportPath != NULL))
+		usage(argv[0]);
+	if(exportPath != NULL && exportFormat == EXPORT_DIMACS && !isPureBoolean(options)) {
+		std::cerr << "DIMACS needs a pure-Boolean encoding: --pebbles=seqcounter|totalizer|sortnet"
+				<< " and --amo=pairwise|ladder|commander" << std::endl;
+		return 1;
+	}
+	sweepThreads = std::max(sweepThreads, (uint32_t)1);
 
-    uint32_t budget = (uint32_t)atoi(argv[1]); // Maximum I/O budget - deadline
-    uint32_t nbRedPebbles = (uint32_t)atoi(argv[2]); // Number of registers
+	context ctx;
+	// The portfolio and sweep threads already occupy the cores
+	set_param("parallel.enable", portfolioThreads == 0 && !sweep);
+
+    run_report report;
+    phase_clock clock = startPhase();
+
+    const dag* programDag;
+    if(dagFile != NULL) {
+        std::cout << "# This is SMT-LB-IO for " << dagFile << std::endl;
+        std::cout << "# Loading DAG from file" << std::endl;
+        programDag = loadDAGFile(dagFile);
+    } else if(generateSpec != NULL) {
+        std::cout << "# This is SMT-LB-IO for " << generateSpec << std::endl;
+        std::cout << "# Generating DAG" << std::endl;
+        programDag = generateDAG(generateSpec);
+        if(programDag == NULL) {
+            std::cerr << "Can't generate " << generateSpec << ", the families are: ";
+            listDAGFamilies(std::cerr);
+        }
+    } else {
+        std::cout << "# This is SMT-LB-IO for " << builtinName << std::endl;
+        std::cout << "# Creating DAG from matrix representation" << std::endl;
+        programDag = builtinDAG(builtinName);
+        if(programDag == NULL) {
+            std::cerr << "No built-in DAG " << builtinName << ", try one of: ";
+            listBuiltinDAGs(std::cerr);
+        }
+    }
+    if(programDag == NULL)
+        return 1;
+    endPhase(&report, "dag", clock);
+
+    if(convertTo != NULL)
+        return writeBinaryDAG(programDag, convertTo) ? 0 : 1;
+
+    if(sweep) {
+        sweep_range budgets, registers;
+        if(!parseRange(argv[optind], budgets) || !parseRange(argv[optind + 1], registers))
+            usage(argv[0]);
+        sweep_result found = paretoSweep(programDag, budgets, registers,
+                horizonGiven ? givenHorizon : NO_HORIZON, options, sweepThreads);
+        std::cout << "# Sweep: " << std::to_string(found.nbSolved) << " of " << std::to_string(found.cells.size())
+                << " cells solved, the others inferred" << std::endl;
+        printFrontierCSV(found, std::cout);
+        return 0;
+    }
+
+    uint32_t budget = (uint32_t)atoi(argv[optind]); // Maximum I/O budget - deadline
+    uint32_t nbRedPebbles = (uint32_t)atoi(argv[optind + 1]); // Number of registers
+
+    reportField(report, "dag", std::string(dagFile != NULL ? dagFile : (generateSpec != NULL ? generateSpec : builtinName)));
+    reportField(report, "engine", std::string(options.engine == ENGINE_LIVENESS ? "liveness" : "interval"));
+    reportField(report, "pebbles", std::string(pebbleEncodingNames[options.pebbles]));
+    reportField(report, "amo", std::string(amoEncodingNames[options.amo]));
+    reportField(report, "nodes", (uint64_t)programDag->nbNodes);
+    reportField(report, "budget", (uint64_t)budget);
+    reportField(report, "registers", (uint64_t)nbRedPebbles);
+
+    // Without a horizon, the budget is the deadline. With one, it is the
+    // number of loads and stores allowed within the horizon.
+    uint32_t horizon = budget;
+    if(horizonGiven) {
+        horizon = givenHorizon;
+        if(strategy == SEARCH_NONE)
+            options.ioBudget = budget;
+    }
+
+    // Unsat on the reduced DAG, with the horizon and the budget lowered by
+    // what it saves, is unsat on the original one
+    dag_reduction reducedDag;
+    dag_reduction* reduction = NULL;
+    if(reduce) {
+        reducedDag = reduceDAG(programDag);
+        reduction = &reducedDag;
+        std::cout << "# Reduced DAG: " << std::to_string(programDag->nbNodes) << " -> "
+                << std::to_string(reducedDag.reduced->nbNodes) << " nodes, "
+                << std::to_string(reducedDag.nbCollapsed) << " collapsed into chains, "
+                << std::to_string(reducedDag.twins.size()) << " output twins, "
+                << std::to_string(reducedDag.nbIsolated) << " isolated; "
+                << std::to_string(reducedDag.dateOffset) << " dates and "
+                << std::to_string(reducedDag.ioOffset) << " loads/stores saved" << std::endl;
+        bool noBudget = (options.ioBudget == NO_IO_BUDGET);
+        endPhase(&report, "reduce", clock);
+        reportField(report, "reduced_nodes", (uint64_t)reducedDag.reduced->nbNodes);
+        if(horizon < reducedDag.dateOffset || (!noBudget && options.ioBudget < reducedDag.ioOffset)) {
+            std::cout << "# Result: No valid schedule exists" << std::endl;
+            reportField(report, "result", std::string("unsat"));
+            emitReport(report, reportPath);
+            return 0;
+        }
+        horizon -= reducedDag.dateOffset;
+        if(!noBudget)
+            options.ioBudget -= reducedDag.ioOffset;
+        programDag = reducedDag.reduced;
+    }
+
+    if(comparePebbles) {
+        encoding_options compared = options;
+        for(uint32_t i = 0; i <= PEBBLES_SORTING_NETWORK; ++i) {
+            compared.pebbles = (pebble_encoding)i;
+            reportEncoding(programDag, horizon, nbRedPebbles, compared, pebbleEncodingNames[i]);
+        }
+        return 0;
+    }
+
+    if(portfolioThreads > 0) {
+        try {
+            portfolio_result found = portfolioSolve(programDag, nbRedPebbles, horizon, options, portfolioThreads);
+            std::cout << "# Result: ";
+            if(found.result == sat) {
+                std::cout << "There is a valid schedule" << std::endl;
+                checkSchedule(programDag, *found.solution, horizon, nbRedPebbles, *found.symbols, reduction);
+            } else if(found.result == unsat) {
+                std::cout << "No valid schedule exists" << std::endl;
+            } else {
+                std::cout << "It is unknown whether a valid schedule exists" << std::endl;
+            }
+            freePortfolioResult(found);
+        } catch(exception& e) {
+            std::cout << e.msg() << std::endl;
+        }
+        return 0;
+    }
+
+    if(exportPath != NULL) {
+        constraint_sink sink;
+        if(!openConstraintSink(sink, exportPath, exportFormat))
+            return 1;
+        std::cout << "# Exporting constraints to " << exportPath << std::endl;
+        expr_vector constraints(ctx);
+        symbol_table symbols;
+        dagToConstraints(programDag, nbRedPebbles, horizon, options, ctx, constraints, symbols, &report, &sink);
+        bool written = closeConstraintSink(sink);
+        std::cout << "# Exported " << std::to_string(sink.nbAssertions) << " constraints";
+        if(exportFormat == EXPORT_DIMACS)
+            std::cout << " as " << std::to_string(sink.nbVariables) << " variables and "
+                    << std::to_string(sink.nbClauses) << " clauses";
+        std::cout << std::endl;
+        reportField(report, "exported_constraints", sink.nbAssertions);
+        if(exportFormat == EXPORT_DIMACS) {
+            reportField(report, "variables", (uint64_t)sink.nbVariables);
+            reportField(report, "clauses", sink.nbClauses);
+        }
+        emitReport(report, reportPath);
+        return written ? 0 : 1;
+    }
+
+    // Deadline: the shortest greedy schedule. Horizon: the cheapest one within it.
+    greedy_schedule upper;
+    upper.found = false;
+    uint32_t upperBudget = NO_BUDGET;
+    if(upperBound && !registerRange) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        upper = bestGreedySchedule(programDag, nbRedPebbles, !horizonGiven, horizon);
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        endPhase(&report, "greedy", clock);
+        if(upper.found) {
+            reportField(report, "greedy_dates", (uint64_t)upper.events.size());
+            reportField(report, "greedy_io_cost", (uint64_t)upper.cost);
+            upperBudget = horizonGiven ? upper.cost : upper.events.size();
+            std::cout << "# Upper bound: " << std::to_string(upper.events.size()) << " dates, "
+                    << std::to_string(upper.cost) << " loads/stores (greedy, " << orderPolicyNames[upper.policy] << " order, "
+                    << std::chrono::duration<double, std::milli>(end - start).count() << " ms)" << std::endl;
+        } else {
+            std::cout << "# Upper bound: no greedy schedule within " << std::to_string(horizon) << " dates and "
+                    << std::to_string(nbRedPebbles) << " registers" << std::endl;
+        }
+    }
 
-    dagToConstraints(programDag, nbRedPebbles, budget, ctx, constraints, symbols);
+    std::cout << "# Creating constraints from the DAG" << std::endl;
+    expr_vector constraints(ctx);
 
+    symbol_table symbols;
+
+    reportField(report, "horizon", (uint64_t)horizon);
+    if(!dagToConstraints(programDag, nbRedPebbles, horizon, options, ctx, constraints, symbols, &report)
+            && strategy == SEARCH_NONE && !registerRange) {
+        std::cout << "# Result: No valid schedule exists" << std::endl;
+        reportField(report, "result", std::string("unsat"));
+        emitReport(report, reportPath);
+        return 0;
+    }
+    clock = startPhase();
+
+    uint64_t nbVariables;
+    uint64_t size = formulaSize(constraints, &nbVariables);
+    std::cout << "# Encoding: " << std::to_string(nbVariables) << " variables, "
+            << std::to_string(constraints.size()) << " constraints, " << std::to_string(size) << " terms, "
+            << std::to_string(symbols.symbols.size()) << " event symbols" << std::endl;
+    endPhase(&report, "formula_size", clock);
+    reportField(report, "variables", nbVariables);
+    reportField(report, "constraints", (uint64_t)constraints.size());
+    reportField(report, "terms", size);
+    reportField(report, "event_symbols", (uint64_t)symbols.symbols.size());
+
+    budget_guards guards = { GUARD_HORIZON, expr_vector(ctx) };
+    if(strategy != SEARCH_NONE) {
+        if(horizonGiven)
+            guards = buildIOGuards(symbols, horizon, budget, ctx, constraints);
+        else
+            guards = buildTimeGuards(symbols, horizon, ctx, constraints);
+        endPhase(&report, "budget_guards", clock);
+    }
+
+	solver s = makeSolver(ctx, options);
+	expr simpl_to_solve = ctx.bool_val(true);
+	std::vector<goal> preprocessed;
+	if(pipelineText != NULL) {
+		std::cout << "# Built constraints - Running the tactic pipeline " << pipelineText << std::endl;
+		reportField(report, "pipeline", std::string(pipelineText));
+		try {
+			preprocessed = runPipeline(pipeline, constraints, ctx, &report);
+		} catch(exception& e) {
+			std::cout << e.msg() << std::endl;
+			reportField(report, "error", std::string(e.msg()));
+			emitReport(report, reportPath);
+			return 1;
+		}
+		uint64_t nbFormulas = 0, nbTerms = 0;
+		for(uint32_t i = 0; i < preprocessed.size(); ++i) {
+			nbFormulas += preprocessed[i].size();
+			nbTerms += preprocessed[i].num_exprs();
+		}
+		reportField(report, "preprocessed_formulas", nbFormulas);
+		reportField(report, "preprocessed_terms", nbTerms);
+		std::cout << "# Solving the problem" << std::endl;
+	} else {
+		std::cout << "# Built constraints - Simplifying expression" << std::endl;
 
-    std::cout << "# Built constraints - Simplifying expression" << std::endl;
+		expr to_solve = mk_and(constraints);
+		simpl_to_solve = to_solve.simplify();
+		endPhase(&report, "simplify", clock);
 
-	expr to_solve = mk_and(constraints);
-	expr simpl_to_solve = to_solve.simplify();
+		std::cout << "# Solving the problem" << std::endl;
 
-	std::cout << "# Solving the problem" << std::endl;
+		s.add(simpl_to_solve);
+		endPhase(&report, "assert", clock);
+	}
 
-	solver s(ctx);
+	// A check under the greedy schedule: its model, if the encoding accepts
+	// it, and the phases the solver caches from it
+	expr_vector greedyEvents(ctx);
+	bool seeded = upper.found && pipelineText == NULL && scheduleAssumptions(upper.events, symbols, greedyEvents);
+	if(upper.found && !seeded && pipelineText == NULL)
+		std::cout << "# The encoding can't express the greedy schedule" << std::endl;
+
+	if(strategy != SEARCH_NONE) {
+		if(seeded) {
+			// Under the guards too, so that a sat hint certifies upperBudget
+			expr_vector hintAssumptions = budgetAssumptions(guards, upperBudget);
+			for(unsigned i = 0; i < greedyEvents.size(); ++i)
+				hintAssumptions.push_back(greedyEvents[i]);
+			check_result hint = s.check(hintAssumptions);
+			endPhase(&report, "greedy_check", clock);
+			std::cout << "# Greedy schedule " << (hint == sat ? "accepted, phases seeded" : "rejected by the encoding") << std::endl;
+			if(hint != sat)
+				upperBudget = NO_BUDGET;
+		} else {
+			upperBudget = NO_BUDGET;
+		}
+		// The greedy schedule is sat at upperBudget: search below it
+		uint32_t maxBudget = budget;
+		if(upperBudget != NO_BUDGET && upperBudget > 0 && upperBudget <= budget)
+			maxBudget = upperBudget - 1;
+		budget_search_result found = budgetSearch(s, guards, minBudget, maxBudget, strategy);
+		endPhase(&report, "search", clock);
+		if(found.tightestSat == NO_BUDGET && upperBudget <= budget)
+			found.tightestSat = upperBudget;
+		std::cout << "# Tightest pair after " << std::to_string(found.nbChecks) << " checks: ";
+		if(found.tightestUnsat != NO_BUDGET)
+			std::cout << "unsat at " << std::to_string(found.tightestUnsat);
+		else
+			std::cout << "no unsat budget";
+		if(found.tightestSat != NO_BUDGET)
+			std::cout << ", sat at " << std::to_string(found.tightestSat) << std::endl;
+		else
+			std::cout << ", no sat budget up to " << std::to_string(budget) << std::endl;
+		reportSearch(report, found);
+		reportSolverStatistics(report, s.statistics());
+		emitReport(report, reportPath);
+		return 0;
+	}
 
-	s.add(simpl_to_solve);
+	if(registerRange) {
+		budget_search_result found = registerSearch(s, options.minRegisters, nbRedPebbles);
+		endPhase(&report, "search", clock);
+		std::cout << "# Tightest pair after " << std::to_string(found.nbChecks) << " checks: ";
+		if(found.tightestUnsat != NO_BUDGET)
+			std::cout << "unsat with " << std::to_string(found.tightestUnsat) << " registers";
+		else
+			std::cout << "no unsat register count";
+		if(found.tightestSat != NO_BUDGET)
+			std::cout << ", sat with " << std::to_string(found.tightestSat) << " registers" << std::endl;
+		else
+			std::cout << ", no sat register count up to " << std::to_string(nbRedPebbles) << std::endl;
+		reportSearch(report, found);
+		reportSolverStatistics(report, s.statistics());
+		emitReport(report, reportPath);
+		return 0;
+	}
 	//std::cout << s << "\n";
 	//std::cout << s.to_smt2() << "\n";
 	try {
-		check_result solve_result = s.check();
-		std::cout << "# Result: ";
-		if(solve_result == sat) {
-			std::cout << "There is a valid schedule" << std::endl;
-			model result = s.get_model();
-
-			symbol_list scheduleSymbols;
-
-			for(uint32_t i = 0; i < result.num_consts(); ++i) {
-				func_decl decl = result.get_const_decl(i);
-				expr body = result.get_const_interp(decl);
-				if(body.is_bool() && body.bool_value() == true) {
-					registered_symbol sym = lookupRegisteredSymbol(decl.name().str(), symbols);
-					scheduleSymbols.push_back(sym);
-				}
+		check_result solve_result;
+		if(minimiseIO) {
+			// One MaxSAT call: every load or store is a violated soft clause
+			optimize opt(ctx);
+			opt.add(simpl_to_solve);
+			expr_vector io = ioSymbols(symbols, horizon, ctx);
+			for(uint32_t i = 0; i < io.size(); ++i)
+				opt.add_soft(!io[i], 1);
+			solve_result = opt.check();
+			endPhase(&report, "solve", clock);
+			reportSolverStatistics(report, opt.statistics());
+			std::cout << "# Result: ";
+			if(solve_result == sat) {
+				model result = opt.get_model();
+				uint32_t nbIO = 0;
+				for(uint32_t i = 0; i < io.size(); ++i)
+					nbIO += result.eval(io[i], true).is_true() ? 1 : 0;
+				std::cout << "Minimum I/O within horizon " << std::to_string(horizon) << ": " << std::to_string(nbIO) << std::endl;
+				reportField(report, "minimum_io", (uint64_t)nbIO);
+				simulation_report replay = checkSchedule(programDag, result, horizon, nbRedPebbles, symbols, reduction);
+				endPhase(&report, "validation", clock);
+				reportSchedule(report, replay);
 			}
-
-			// print by schedule
-			for(uint32_t t = 0; t < budget; t++) {
-				symbol_list::iterator i;
-				for(i = scheduleSymbols.begin(); i < scheduleSymbols.end(); ++i)
-					if(i->date == t)
-						std::cout << i->symbol.to_string() << " ";
+		} else if(pipelineText != NULL) {
+			model result(ctx);
+			solve_result = solvePipeline(pipeline, preprocessed, isPureBoolean(options), ctx, result);
+			endPhase(&report, "solve", clock);
+			std::cout << "# Result: ";
+			if(solve_result == sat) {
+				std::cout << "There is a valid schedule" << std::endl;
+				simulation_report replay = checkSchedule(programDag, result, horizon, nbRedPebbles, symbols, reduction);
+				endPhase(&report, "validation", clock);
+				reportSchedule(report, replay);
 			}
-			std::cout << std::endl;
-
-			std::cout << "# Checking for the schedule's validity" << std::endl;
-			// Check for schedule validity
-			uint32_t t, nR1, nR2;
-			node** regs = (node**)calloc(nbRedPebbles, sizeof(node*));
-			for(t = 0; t < budget; t++) {
-				symbol_list::iterator i;
-				for(i = scheduleSymbols.begin(); (i < scheduleSymbols.end()) && (i->date != t); ++i);
-				if(i == scheduleSymbols.end())
-					break; // we are done
-				if(i->date == t) {
-					if(i->r == RULE_R1) {
-						uint32_t j;
-						for(j = 0; (j < nbRedPebbles) && (regs[j] != NULL); ++j);
-						if(j == nbRedPebbles) {
-							std::cout << "INVALID: Register file full on load" << std::endl;
-							break;
-						}
-						if(i->n->deleted) {
-							std::cout << "INVALID: Value deleted on load" << std::endl;
-							break;
-						}
-						regs[j] = i->n;
-						nR1 += 1;
-
-					} else if(i->r == RULE_R2) {
-						uint32_t j;
-						for(j = 0; (j < nbRedPebbles) && (regs[j] != i->n); ++j);
-						if(j == nbRedPebbles) {
-							std::cout << "INVALID: Value not in registers on store" << std::endl;
-							break;
-						}
-						if(i->n->deleted) {
-							std::cout << "INVALID: Value deleted on store" << std::endl;
-							break;
-						}
-						regs[j] = NULL;
-
-						nR2 += 1;
-
-					} else if(i->r == RULE_R3) {
-						uint32_t j, k;
-						for(k = 0; k < i->n->nbPredecessors; ++k) {
-							for(j = 0; (j < nbRedPebbles) && (regs[j] != i->n->predecessors[k]); ++j);
-							if(j == nbRedPebbles) {
-								std::cout << "INVALID: Dependency not satisfied" << std::endl;
-								break;
-							}
-							if(i->n->predecessors[k]->deleted) {
-								std::cout << "INVALID: Dependency deleted" << std::endl;
-								break;
-							}
-						}
-						if(k < i->n->nbPredecessors)
-							break; // one at least is missing
-						for(j = 0; (j < nbRedPebbles) && (regs[j] != NULL); ++j);
-						if(j == nbRedPebbles) {
-							std::cout << "INVALID: Register file full on compute" << std::endl;
-							break;
-						}
-						regs[j] = i->n;
-
-					} else if(i->r == RULE_R4) {
-						uint32_t j;
-						for(j = 0; (j < nbRedPebbles) && (regs[j] != i->n); ++j);
-						if(j == nbRedPebbles) {
-							std::cout << "INVALID: Value not in memory on delete" << std::endl;
-							break;
-						}
-						if(i->n->deleted) {
-							std::cout << "INVALID: Value already deleted on delete" << std::endl;
-							break;
-						}
-						regs[j] = NULL;
-						i->n->deleted = true;
-					}
-				}
-
+		} else {
+			solve_result = unknown;
+			if(seeded) {
+				solve_result = s.check(greedyEvents);
+				endPhase(&report, "greedy_check", clock);
+				std::cout << "# Greedy schedule " << (solve_result == sat ? "accepted" : "rejected by the encoding") << std::endl;
 			}
-			if(t == budget)
-				std::cout << "Schedule VALID :) I/O cost: " << std::to_string(nR1 + nR2) << std::endl;
-
+			if(solve_result != sat) {
+				solve_result = s.check();
+				endPhase(&report, "solve", clock);
+			}
+			reportSolverStatistics(report, s.statistics());
+			std::cout << "# Result: ";
+			if(solve_result == sat) {
+				std::cout << "There is a valid schedule" << std::endl;
+				model result = s.get_model();
+				simulation_report replay = checkSchedule(programDag, result, horizon, nbRedPebbles, symbols, reduction);
+				endPhase(&report, "validation", clock);
+				reportSchedule(report, replay);
+			}
+		}
 
-		} else if(solve_result == unsat) {
+		if(solve_result == unsat) {
 			std::cout << "No valid schedule exists" << std::endl;
-		} else { // unknown
+		} else if(solve_result == unknown) {
 			std::cout << "It is unknown whether a valid schedule exists" << std::endl;
 		}
+		reportField(report, "result", std::string(resultName(solve_result)));
 
     } catch(exception& e) {
     	std::cout << e.msg() << std::endl;
+    	reportField(report, "error", std::string(e.msg()));
     };
 
+	emitReport(report, reportPath);
 	return 0;
 }
@@ -0,0 +1,169 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+#include "pipeline.h"
+#include <cstring>
+#include <sstream>
+
+typedef struct pipeline_preset {
+	const char* name;
+	const char* stages;
+} pipeline_preset;
+
+static const pipeline_preset pipelinePresets[] = {
+	{ "simplify", "simplify" },
+	{ "sat", "simplify,propagate-values,card2bv,bit-blast,sat" },
+	{ "smt", "simplify,propagate-values,solve-eqs,elim-uncnstr,smt" },
+	{ "pb", "simplify,propagate-values,lia2pb,pb2bv,bit-blast,sat" },
+};
+#define NB_PIPELINE_PRESETS (sizeof(pipelinePresets) / sizeof(pipeline_preset))
+
+bool parseStage(const std::string& text, tactic_stage& stage);
+bool parseStages(const char* text, tactic_pipeline& pipeline);
+tactic stageTactic(tactic_stage& stage, context& ctx);
+void printGoalsSize(std::vector<goal>& goals);
+
+// "name:key=value:key=value"
+bool parseStage(const std::string& text, tactic_stage& stage) {
+	std::istringstream fields(text);
+	std::string field;
+	if(!std::getline(fields, stage.name, ':') || stage.name.empty())
+		return false;
+	while(std::getline(fields, field, ':')) {
+		size_t equals = field.find('=');
+		if(equals == std::string::npos || equals == 0)
+			return false;
+		stage.parameters.push_back(std::make_pair(field.substr(0, equals), field.substr(equals + 1)));
+	}
+	return true;
+}
+
+bool parsePipeline(const char* text, tactic_pipeline& pipeline) {
+	for(uint32_t i = 0; i < NB_PIPELINE_PRESETS; ++i) {
+		if(strcmp(text, pipelinePresets[i].name) == 0)
+			return parseStages(pipelinePresets[i].stages, pipeline);
+	}
+	return parseStages(text, pipeline);
+}
+
+bool parseStages(const char* text, tactic_pipeline& pipeline) {
+	pipeline.stages.clear();
+	pipeline.backend = BACKEND_AUTO;
+	std::istringstream items(text);
+	std::string item;
+	while(std::getline(items, item, ',')) {
+		if(pipeline.backend != BACKEND_AUTO)
+			return false; // the backend comes last
+		if(item == "sat") {
+			pipeline.backend = BACKEND_SAT;
+			continue;
+		}
+		if(item == "smt") {
+			pipeline.backend = BACKEND_SMT;
+			continue;
+		}
+		tactic_stage stage;
+		if(!parseStage(item, stage))
+			return false;
+		pipeline.stages.push_back(stage);
+	}
+	return !pipeline.stages.empty() || pipeline.backend != BACKEND_AUTO;
+}
+
+void listPipelinePresets(std::ostream& out) {
+	for(uint32_t i = 0; i < NB_PIPELINE_PRESETS; ++i)
+		out << (i > 0 ? ", " : "") << pipelinePresets[i].name << " (" << pipelinePresets[i].stages << ")";
+	out << std::endl;
+}
+
+// Parameter values are Booleans, unsigned integers or doubles, or else symbols
+tactic stageTactic(tactic_stage& stage, context& ctx) {
+	tactic t(ctx, stage.name.c_str());
+	if(stage.parameters.empty())
+		return t;
+	params p(ctx);
+	for(uint32_t i = 0; i < stage.parameters.size(); ++i) {
+		const char* key = stage.parameters[i].first.c_str();
+		const std::string& value = stage.parameters[i].second;
+		char* end;
+		if(value == "true" || value == "false") {
+			p.set(key, value == "true");
+		} else if(strtoul(value.c_str(), &end, 10), *end == '\0') {
+			p.set(key, (unsigned)strtoul(value.c_str(), NULL, 10));
+		} else if(strtod(value.c_str(), &end), *end == '\0') {
+			p.set(key, strtod(value.c_str(), NULL));
+		} else {
+			p.set(key, ctx.str_symbol(value.c_str()));
+		}
+	}
+	return with(t, p);
+}
+
+void printGoalsSize(std::vector<goal>& goals) {
+	uint64_t formulas = 0, terms = 0;
+	uint32_t nbDecided = 0;
+	for(uint32_t i = 0; i < goals.size(); ++i) {
+		formulas += goals[i].size();
+		terms += goals[i].num_exprs();
+		nbDecided += (goals[i].is_decided_sat() || goals[i].is_decided_unsat()) ? 1 : 0;
+	}
+	if(goals.size() > 1)
+		std::cout << std::to_string(goals.size()) << " goals, ";
+	std::cout << std::to_string(formulas) << " formulas, " << std::to_string(terms) << " terms";
+	if(nbDecided > 0)
+		std::cout << ", " << std::to_string(nbDecided) << " decided";
+}
+
+std::vector<goal> runPipeline(tactic_pipeline& pipeline, expr_vector& constraints, context& ctx, run_report* report) {
+	// Models on, so that every stage records how to convert them back
+	std::vector<goal> goals(1, goal(ctx, true, false, false));
+	for(unsigned i = 0; i < constraints.size(); ++i)
+		goals[0].add(constraints[i]);
+	std::cout << "## Goal: ";
+	printGoalsSize(goals);
+	std::cout << std::endl;
+
+	for(uint32_t i = 0; i < pipeline.stages.size(); ++i) {
+		tactic_stage& stage = pipeline.stages[i];
+		phase_clock clock = startPhase();
+		tactic t = stageTactic(stage, ctx);
+		// A splitting tactic gives several subgoals, one of them has to be sat
+		std::vector<goal> next;
+		for(uint32_t j = 0; j < goals.size(); ++j) {
+			apply_result result = t(goals[j]);
+			for(unsigned k = 0; k < result.size(); ++k)
+				next.push_back(result[k]);
+		}
+		goals = next;
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - clock.wall).count();
+		endPhase(report, ("tactic:" + stage.name).c_str(), clock);
+		std::cout << "## Tactic " << stage.name << ": " << seconds << " s, ";
+		printGoalsSize(goals);
+		std::cout << std::endl;
+	}
+	return goals;
+}
+
+// The backend is a tactic as well: only a goal it decides converts its model
+// back through the stages
+check_result solvePipeline(tactic_pipeline& pipeline, std::vector<goal>& goals, bool pureBoolean, context& ctx, model& solution) {
+	const char* backend = (pipeline.backend == BACKEND_SAT) ? "sat"
+			: (pipeline.backend == BACKEND_SMT || !pureBoolean) ? "smt" : "qffd";
+	tactic t(ctx, backend);
+	check_result ret = unsat;
+	for(uint32_t i = 0; i < goals.size(); ++i) {
+		apply_result result = t(goals[i]);
+		for(unsigned j = 0; j < result.size(); ++j) {
+			if(result[j].is_decided_sat()) {
+				solution = result[j].convert_model(model(ctx));
+				return sat;
+			}
+			if(!result[j].is_decided_unsat())
+				ret = unknown;
+		}
+	}
+	return ret;
+}
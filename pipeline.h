@@ -0,0 +1,58 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+/*
+ * Preprocessing by a sequence of Z3 tactics before the solver, instead of one
+ * simplify() of the whole conjunction. A pipeline is a preset name, or a
+ * comma-separated list of stages "tactic[:param=value]*", optionally ended by
+ * the backend: sat (Z3's SAT core, for goals bit-blasted by the stages) or
+ * smt. Without one, it is chosen from the encoding: the finite-domain tactic
+ * for the pure-Boolean encodings, as with the QF_FD solver, or else smt.
+ *
+ * The backend is applied as a tactic too: a model then converts back through
+ * every stage to the symbols of the encoding. (A model from a separate solver
+ * doesn't survive elim-uncnstr.) Tactics may eliminate any variable, so the
+ * goals can't be solved under assumptions on the original symbols.
+ */
+
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include <z3++.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "report.h"
+
+using namespace z3;
+
+typedef enum pipeline_backend {
+	BACKEND_AUTO, // from the encoding, as without a pipeline
+	BACKEND_SAT,
+	BACKEND_SMT
+} pipeline_backend;
+
+typedef struct tactic_stage {
+	std::string name;
+	std::vector<std::pair<std::string, std::string> > parameters;
+} tactic_stage;
+
+typedef struct tactic_pipeline {
+	std::vector<tactic_stage> stages;
+	pipeline_backend backend;
+} tactic_pipeline;
+
+bool parsePipeline(const char* text, tactic_pipeline& pipeline);
+void listPipelinePresets(std::ostream& out);
+
+// Applies the stages in order, printing the time and the size of the goals
+// after each; the time of stage "x" goes to the report as "tactic:x"
+std::vector<goal> runPipeline(tactic_pipeline& pipeline, expr_vector& constraints, context& ctx, run_report* report);
+// Sat with the model of the original constraints if a goal is, unknown if the
+// backend gave up on one
+check_result solvePipeline(tactic_pipeline& pipeline, std::vector<goal>& goals, bool pureBoolean, context& ctx, model& solution);
+
+#endif /* PIPELINE_H_ */
@@ -0,0 +1,195 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+#include "portfolio.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+// Cycled through when there are more threads than configurations, with a new
+// random seed on every round
+static portfolio_config portfolioConfigs[] = {
+	{ "user/smt",               true,  PEBBLES_SUM,                AMO_PB,        false, PHASE_CACHING },
+	{ "seqcounter/sat",         false, PEBBLES_SEQUENTIAL_COUNTER, AMO_LADDER,    true,  PHASE_CACHING },
+	{ "totalizer/sat",          false, PEBBLES_TOTALIZER,          AMO_COMMANDER, true,  PHASE_CACHING },
+	{ "prefix/smt",             false, PEBBLES_PREFIX,             AMO_PB,        false, PHASE_CACHING },
+	{ "seqcounter/sat/random",  false, PEBBLES_SEQUENTIAL_COUNTER, AMO_LADDER,    true,  PHASE_RANDOM },
+	{ "user/smt/false",         true,  PEBBLES_SUM,                AMO_PB,        false, PHASE_FALSE },
+	{ "seqcounter/smt",         false, PEBBLES_SEQUENTIAL_COUNTER, AMO_LADDER,    false, PHASE_CACHING },
+	{ "sortnet/sat/false",      false, PEBBLES_SORTING_NETWORK,    AMO_PAIRWISE,  true,  PHASE_FALSE }
+};
+#define NB_PORTFOLIO_CONFIGS (sizeof(portfolioConfigs) / sizeof(portfolio_config))
+
+// State of one thread. Only the thread touches its context while it runs,
+// except for interrupt().
+typedef struct portfolio_thread {
+	portfolio_config config;
+	encoding_options options;
+	uint32_t seed;
+	context* ctx;
+	symbol_table* symbols;
+	solver* s;
+	check_result result;
+	bool finished;
+} portfolio_thread;
+
+// Shared between the threads, under the mutex
+typedef struct portfolio_state {
+	std::mutex lock;
+	std::condition_variable changed;
+	int32_t winner;
+	uint32_t nbFinished;
+	const dag* _dag;
+	uint32_t nbRedPebbles;
+	uint32_t maxTime;
+} portfolio_state;
+
+encoding_options variantOptions(encoding_options& options, portfolio_config& config);
+void setSolverParams(portfolio_thread& thread, uint32_t seed);
+void runPortfolioThread(portfolio_thread* thread, uint32_t index, portfolio_state* state);
+
+encoding_options variantOptions(encoding_options& options, portfolio_config& config) {
+	encoding_options ret = options;
+	if(!config.userEncoding) {
+		ret.pebbles = config.pebbles;
+		ret.amo = config.amo;
+	}
+	return ret;
+}
+
+void setSolverParams(portfolio_thread& thread, uint32_t seed) {
+	params p(*thread.ctx);
+	p.set("random_seed", seed);
+	if(thread.config.satCore) {
+		const char* phases[] = { "caching", "always_false", "random" };
+		p.set("sat.phase", thread.ctx->str_symbol(phases[thread.config.phase]));
+	} else {
+		// See smt.phase_selection: 3 is the default caching, 0 always false, 5 random
+		unsigned phases[] = { 3, 0, 5 };
+		p.set("smt.phase_selection", phases[thread.config.phase]);
+	}
+	thread.s->set(p);
+}
+
+void runPortfolioThread(portfolio_thread* thread, uint32_t index, portfolio_state* state) {
+	check_result result = unknown;
+	try {
+		expr_vector constraints(*thread->ctx);
+		dagToConstraints(state->_dag, state->nbRedPebbles, state->maxTime, thread->options, *thread->ctx, constraints, *thread->symbols);
+		thread->s = thread->config.satCore ? new solver(*thread->ctx, "QF_FD") : new solver(*thread->ctx);
+		setSolverParams(*thread, thread->seed);
+		thread->s->add(mk_and(constraints).simplify());
+
+		// An interrupt before check() is lost: don't start once another
+		// thread has concluded
+		bool decided;
+		{
+			std::lock_guard<std::mutex> guard(state->lock);
+			decided = state->winner >= 0;
+		}
+		if(!decided)
+			result = thread->s->check();
+	} catch(exception& e) {
+		// Interrupted, or out of resources: either way, not conclusive
+		result = unknown;
+	}
+
+	std::lock_guard<std::mutex> guard(state->lock);
+	thread->result = result;
+	thread->finished = true;
+	state->nbFinished += 1;
+	if(result != unknown && state->winner < 0)
+		state->winner = index;
+	state->changed.notify_all();
+}
+
+portfolio_result portfolioSolve(const dag* _dag, uint32_t nbRedPebbles, uint32_t maxTime, encoding_options& options, uint32_t nbThreads) {
+	portfolio_result ret = { unknown, -1, NULL, NULL, NULL };
+	std::vector<portfolio_thread> threads(nbThreads);
+	uint32_t i;
+
+	// The contexts exist before the threads start, so that they can be
+	// interrupted at any time
+	for(i = 0; i < nbThreads; ++i) {
+		portfolio_config config = portfolioConfigs[i % NB_PORTFOLIO_CONFIGS];
+		threads[i].options = variantOptions(options, config);
+		if(!isPureBoolean(threads[i].options))
+			config.satCore = false;
+		threads[i].config = config;
+		threads[i].seed = i / NB_PORTFOLIO_CONFIGS;
+		threads[i].ctx = new context();
+		threads[i].symbols = new symbol_table();
+		threads[i].s = NULL;
+		threads[i].result = unknown;
+		threads[i].finished = false;
+		std::cout << "# Portfolio: thread " << std::to_string(i) << " builds and solves " << config.name << std::endl;
+	}
+
+	std::cout << "# Portfolio: solving with " << std::to_string(nbThreads) << " threads" << std::endl;
+	portfolio_state state;
+	state.winner = -1;
+	state.nbFinished = 0;
+	state._dag = _dag;
+	state.nbRedPebbles = nbRedPebbles;
+	state.maxTime = maxTime;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for(i = 0; i < nbThreads; ++i)
+		workers.push_back(std::thread(runPortfolioThread, &threads[i], i, &state));
+
+	{
+		std::unique_lock<std::mutex> guard(state.lock);
+		state.changed.wait(guard, [&state, nbThreads] { return state.winner >= 0 || state.nbFinished == nbThreads; });
+		// A thread may not have entered check() yet when it is first
+		// interrupted, so keep interrupting until every one is back.
+		while(state.nbFinished < nbThreads) {
+			for(i = 0; i < nbThreads; ++i) {
+				if(!threads[i].finished)
+					threads[i].ctx->interrupt();
+			}
+			state.changed.wait_for(guard, std::chrono::milliseconds(10));
+		}
+	}
+	for(i = 0; i < nbThreads; ++i)
+		workers[i].join();
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+	ret.winner = state.winner;
+	if(ret.winner >= 0) {
+		portfolio_thread& winner = threads[ret.winner];
+		std::cout << "# Portfolio: thread " << std::to_string(ret.winner) << " (" << winner.config.name
+				<< ") concluded first, after " << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+
+		ret.result = winner.result;
+		if(ret.result == sat)
+			ret.solution = new model(winner.s->get_model());
+		ret.ctx = winner.ctx;
+		ret.symbols = winner.symbols;
+		winner.ctx = NULL;
+	}
+
+	for(i = 0; i < nbThreads; ++i) {
+		delete threads[i].s;
+		if(threads[i].ctx != NULL) {
+			delete threads[i].symbols;
+			delete threads[i].ctx;
+		}
+	}
+
+	return ret;
+}
+
+void freePortfolioResult(portfolio_result& result) {
+	// Everything that refers to the context goes first
+	delete result.solution;
+	delete result.symbols;
+	delete result.ctx;
+	result.solution = NULL;
+	result.symbols = NULL;
+	result.ctx = NULL;
+}
@@ -0,0 +1,57 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+/*
+ * Portfolio solving: the same problem is solved by N threads, each in its own
+ * Z3 context, with a different configuration (random seed, SAT or SMT core,
+ * phase selection, pebble and at-most-one encodings). The first thread to
+ * conclude sat or unsat wins, and the others are stopped with
+ * context::interrupt().
+ *
+ * Each thread builds its encoding in its own context, since Z3 contexts can't
+ * be shared between threads. The DAG is read-only, so the builds run
+ * concurrently and no thread waits for the others' encodings.
+ */
+
+#ifndef PORTFOLIO_H_
+#define PORTFOLIO_H_
+
+#include <z3++.h>
+#include "sat-version.h"
+
+using namespace z3;
+
+typedef enum phase_selection {
+	PHASE_CACHING,
+	PHASE_FALSE,
+	PHASE_RANDOM
+} phase_selection;
+
+// The encoding variants keep the engine chosen by the user: the engines don't
+// model exactly the same game, and the portfolio must answer for one of them.
+typedef struct portfolio_config {
+	const char* name;
+	bool userEncoding; // as given, otherwise with the pebbles and amo below
+	pebble_encoding pebbles;
+	amo_encoding amo;
+	bool satCore; // QF_FD solver, if the encoding is pure Boolean
+	phase_selection phase;
+} portfolio_config;
+
+// Outcome of a portfolio run. The model and symbols belong to the context of
+// the winning thread, and are freed with freePortfolioResult.
+typedef struct portfolio_result {
+	check_result result;
+	int32_t winner; // thread that concluded first, -1 if none did
+	context* ctx;
+	symbol_table* symbols;
+	model* solution; // NULL unless sat
+} portfolio_result;
+
+portfolio_result portfolioSolve(const dag* _dag, uint32_t nbRedPebbles, uint32_t maxTime, encoding_options& options, uint32_t nbThreads);
+void freePortfolioResult(portfolio_result& result);
+
+#endif /* PORTFOLIO_H_ */
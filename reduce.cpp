@@ -0,0 +1,188 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+#include "reduce.h"
+#include <algorithm>
+#include <map>
+
+using namespace std;
+
+void expandChain(vector<node>& chain, schedule& lifted);
+uint32_t twinPosition(const dag* d, schedule& lifted, node first, node twin);
+
+dag_reduction reduceDAG(const dag* d) {
+    dag_reduction reduction;
+    reduction.original = d;
+    reduction.nbCollapsed = 0;
+    reduction.nbIsolated = 0;
+    reduction.dateOffset = 0;
+    reduction.ioOffset = 0;
+
+    vector<node> order(d->nbNodes);
+    if(!topologicalOrder(d, order.data())) {
+        // Nothing to reduce: the loaders reject cycles, this is only defensive
+        reduction.reduced = d;
+        for(node n = 0; n < d->nbNodes; n++)
+            reduction.chains.push_back(vector<node>(1, n));
+        return reduction;
+    }
+
+    // Chains, identified by their first node. Following the topological
+    // order, each node joins the chain of its predecessor if it can.
+    vector<node> head(d->nbNodes);
+    vector<vector<node> > chainOf(d->nbNodes);
+    for(uint32_t i = 0; i < d->nbNodes; i++) {
+        node n = order[i];
+        head[n] = n;
+        if(nbPredecessors(d, n) == 1) {
+            node p = predecessors(d, n)[0];
+            if(nbPredecessors(d, p) > 0 && nbSuccessors(d, p) == 1) {
+                head[n] = head[p];
+                reduction.nbCollapsed += 1;
+            }
+        }
+        chainOf[head[n]].push_back(n);
+    }
+
+    // Outputs, grouped by the chains of their predecessors. The first one of
+    // each group is kept.
+    map<vector<node>, node> firstTwin;
+    vector<node> twinOfHead(d->nbNodes, NO_NODE);
+    for(uint32_t i = 0; i < d->nbNodes; i++) {
+        node h = order[i];
+        if(head[h] != h)
+            continue;
+        node tail = chainOf[h].back();
+        if(nbSuccessors(d, tail) > 0)
+            continue;
+        if(nbPredecessors(d, h) == 0) {
+            reduction.nbIsolated += 1;
+            continue;
+        }
+
+        vector<node> key;
+        for(uint32_t k = 0; k < nbPredecessors(d, h); k++)
+            key.push_back(head[predecessors(d, h)[k]]);
+        std::sort(key.begin(), key.end());
+        map<vector<node>, node>::iterator twin = firstTwin.find(key);
+        if(twin == firstTwin.end())
+            firstTwin[key] = h;
+        else
+            twinOfHead[h] = twin->second;
+    }
+
+    // Number the chains that are kept, in topological order
+    vector<node> reducedOf(d->nbNodes, NO_NODE);
+    for(uint32_t i = 0; i < d->nbNodes; i++) {
+        node h = order[i];
+        if(head[h] != h || twinOfHead[h] != NO_NODE)
+            continue;
+        if(nbPredecessors(d, h) == 0 && nbSuccessors(d, chainOf[h].back()) == 0)
+            continue; // isolated
+        reducedOf[h] = reduction.chains.size();
+        reduction.chains.push_back(chainOf[h]);
+        reduction.dateOffset += chainOf[h].size() - 1;
+    }
+    for(uint32_t i = 0; i < d->nbNodes; i++) {
+        node h = order[i];
+        if(head[h] != h || twinOfHead[h] == NO_NODE)
+            continue;
+        reduction.twins.push_back(chainOf[h]);
+        reduction.twinOf.push_back(reducedOf[twinOfHead[h]]);
+        reduction.dateOffset += chainOf[h].size() + 1; // computes and store
+        reduction.ioOffset += 1;
+    }
+
+    // Edges between kept chains: from the last node of one to the first of another
+    vector<uint32_t> from, to;
+    for(node r = 0; r < reduction.chains.size(); r++) {
+        node h = reduction.chains[r][0];
+        for(uint32_t k = 0; k < nbPredecessors(d, h); k++) {
+            from.push_back(reducedOf[head[predecessors(d, h)[k]]]);
+            to.push_back(r);
+        }
+    }
+
+    if(reduction.chains.size() == d->nbNodes)
+        reduction.reduced = d; // nothing changed
+    else
+        reduction.reduced = edgeListToDAG(reduction.chains.size(), from.size(), from.data(), to.data());
+    return reduction;
+}
+
+// Computes the chain, deleting each node once its successor is computed
+void expandChain(vector<node>& chain, schedule& lifted) {
+    schedule_event compute = { chain[0], RULE_R3 };
+    lifted.push_back(compute);
+    for(uint32_t i = 1; i < chain.size(); i++) {
+        schedule_event next = { chain[i], RULE_R3 };
+        schedule_event del = { chain[i - 1], RULE_R4 };
+        lifted.push_back(next);
+        lifted.push_back(del);
+    }
+}
+
+// Where to compute and store a twin: once the nodes it shares its
+// predecessors with is computed, and before any of them leaves the registers,
+// at the date with the fewest values in registers.
+uint32_t twinPosition(const dag* d, schedule& lifted, node first, node twin) {
+    vector<bool> red(d->nbNodes, false);
+    vector<bool> isPredecessor(d->nbNodes, false);
+    for(uint32_t k = 0; k < nbPredecessors(d, twin); k++)
+        isPredecessor[predecessors(d, twin)[k]] = true;
+
+    uint32_t live = 0, best = 0, bestLive = UINT32_MAX;
+    bool started = false;
+    for(uint32_t t = 0; t < lifted.size(); t++) {
+        node n = lifted[t].n;
+        bool removes = (lifted[t].r == RULE_R2 || lifted[t].r == RULE_R4);
+        if(started && removes && isPredecessor[n])
+            break;
+        if(removes && red[n]) {
+            red[n] = false;
+            live -= 1;
+        } else if(!removes && !red[n]) {
+            red[n] = true;
+            live += 1;
+        }
+        if(lifted[t].n == first && lifted[t].r == RULE_R3)
+            started = true;
+        if(started && live < bestLive) {
+            bestLive = live;
+            best = t + 1;
+        }
+    }
+    return best;
+}
+
+schedule liftSchedule(dag_reduction& reduction, schedule& reduced) {
+    schedule lifted;
+    for(uint32_t t = 0; t < reduced.size(); t++) {
+        node r = reduced[t].n;
+        if(r == NO_NODE)
+            continue;
+        vector<node>& chain = reduction.chains[r];
+
+        if(reduced[t].r == RULE_R3) {
+            expandChain(chain, lifted);
+        } else {
+            // Once computed, the chain holds the value of its last node
+            schedule_event e = { chain.back(), reduced[t].r };
+            lifted.push_back(e);
+        }
+    }
+
+    for(uint32_t i = 0; i < reduction.twins.size(); i++) {
+        vector<node>& twin = reduction.twins[i];
+        schedule events;
+        expandChain(twin, events);
+        schedule_event store = { twin.back(), RULE_R2 };
+        events.push_back(store);
+        uint32_t position = twinPosition(reduction.original, lifted, reduction.chains[reduction.twinOf[i]][0], twin[0]);
+        lifted.insert(lifted.begin() + position, events.begin(), events.end());
+    }
+    return lifted;
+}
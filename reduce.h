@@ -0,0 +1,56 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+/*
+ * Structural reductions of the DAG before encoding. Each one maps any
+ * schedule of the original DAG to a schedule of the reduced DAG with no more
+ * registers, dateOffset fewer dates and ioOffset fewer loads and stores, so
+ * that "unsat" on the reduced DAG within (horizon - dateOffset, budget -
+ * ioOffset) is "unsat" on the original one. The converse doesn't hold: a
+ * schedule of the reduced DAG is lifted back, then has to be checked.
+ *
+ * - Chain collapse: a node with a single predecessor, itself computed and
+ *   with no other successor, is merged into it. The value of the chain is
+ *   the one of its first node until it is computed, then the one of its last
+ *   node. Saves one compute per merged node.
+ * - Output twins: an output with the same predecessors as another output is
+ *   left out. Its predecessors keep a successor, so they don't become outputs.
+ *   Saves its computes and its store.
+ * - Isolated nodes, which no schedule has to touch.
+ *
+ * Nodes with the same predecessors but other successors can't be merged: a
+ * node is computed once, so the merged node would have to stay in a register
+ * or be stored between the two computes.
+ */
+
+#ifndef REDUCE_H_
+#define REDUCE_H_
+
+#include <vector>
+#include "datastruct.h"
+#include "sat-version.h"
+
+typedef struct dag_reduction {
+    const dag* original;
+    const dag* reduced;
+    // Original nodes of each reduced node, in the order they are computed
+    std::vector<std::vector<node> > chains;
+    // Output twins left out: twins[i] (a chain of original nodes) is computed
+    // and stored right after the reduced node twinOf[i]
+    std::vector<std::vector<node> > twins;
+    std::vector<node> twinOf;
+    uint32_t nbCollapsed;
+    uint32_t nbIsolated;
+    uint32_t dateOffset;
+    uint32_t ioOffset;
+} dag_reduction;
+
+dag_reduction reduceDAG(const dag* d);
+
+// Schedule of the original DAG, without idle dates, from one of the reduced DAG
+schedule liftSchedule(dag_reduction& reduction, schedule& reduced);
+
+#endif /* REDUCE_H_ */
@@ -0,0 +1,124 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+#include "report.h"
+#include <sys/resource.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+double cpuSeconds(struct rusage& usage);
+std::string jsonString(const std::string& text);
+std::string jsonNumber(double value);
+
+double cpuSeconds(struct rusage& usage) {
+	return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6
+		+ usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+}
+
+std::string jsonString(const std::string& text) {
+	std::string ret = "\"";
+	for(uint32_t i = 0; i < text.size(); ++i) {
+		char c = text[i];
+		if(c == '"' || c == '\\') {
+			ret += '\\';
+			ret += c;
+		} else if((unsigned char)c < 0x20) {
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+			ret += escaped;
+		} else {
+			ret += c;
+		}
+	}
+	return ret + "\"";
+}
+
+// JSON has no infinity or NaN
+std::string jsonNumber(double value) {
+	if(value != value || value > 1e308 || value < -1e308)
+		return "null";
+	std::ostringstream out;
+	out.precision(9);
+	out << value;
+	return out.str();
+}
+
+phase_clock startPhase() {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	phase_clock ret = { std::chrono::steady_clock::now(), cpuSeconds(usage) };
+	return ret;
+}
+
+void endPhase(run_report* report, const char* name, phase_clock& start) {
+	phase_clock end = startPhase();
+	if(report != NULL) {
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		phase_timing phase = { name, std::chrono::duration<double>(end.wall - start.wall).count(),
+				end.cpu - start.cpu, (uint64_t)usage.ru_maxrss };
+		report->phases.push_back(phase);
+	}
+	start = end;
+}
+
+void reportField(run_report& report, const char* key, const std::string& value) {
+	report.fields.push_back(std::make_pair(std::string(key), jsonString(value)));
+}
+
+void reportField(run_report& report, const char* key, uint64_t value) {
+	report.fields.push_back(std::make_pair(std::string(key), std::to_string(value)));
+}
+
+void reportSolverStatistics(run_report& report, const stats& st) {
+	for(uint32_t i = 0; i < st.size(); ++i)
+		report.solverStatistics.push_back(std::make_pair(st.key(i), st.is_uint(i) ? st.uint_value(i) : st.double_value(i)));
+}
+
+void writeJSONReport(run_report& report, std::ostream& out) {
+	out << "{";
+	for(uint32_t i = 0; i < report.fields.size(); ++i)
+		out << jsonString(report.fields[i].first) << ":" << report.fields[i].second << ",";
+
+	out << "\"phases\":[";
+	for(uint32_t i = 0; i < report.phases.size(); ++i) {
+		phase_timing& p = report.phases[i];
+		out << (i > 0 ? "," : "") << "{\"name\":" << jsonString(p.name)
+			<< ",\"wall\":" << jsonNumber(p.wall) << ",\"cpu\":" << jsonNumber(p.cpu)
+			<< ",\"peak_rss_kib\":" << std::to_string(p.peakRss) << "}";
+	}
+
+	// Z3 may report a statistic once per tactic or core: the values are summed
+	out << "],\"solver\":{";
+	std::vector<std::pair<std::string, double> > merged;
+	for(uint32_t i = 0; i < report.solverStatistics.size(); ++i) {
+		uint32_t j = 0;
+		while(j < merged.size() && merged[j].first != report.solverStatistics[i].first)
+			j++;
+		if(j == merged.size())
+			merged.push_back(report.solverStatistics[i]);
+		else
+			merged[j].second += report.solverStatistics[i].second;
+	}
+	for(uint32_t i = 0; i < merged.size(); ++i)
+		out << (i > 0 ? "," : "") << jsonString(merged[i].first) << ":" << jsonNumber(merged[i].second);
+	out << "}}" << std::endl;
+}
+
+bool appendJSONReport(run_report& report, const char* path) {
+	if(std::string(path) == "-") {
+		writeJSONReport(report, std::cout);
+		return true;
+	}
+	std::ofstream out(path, std::ios::app);
+	if(!out) {
+		std::cerr << "Can't write the report to " << path << std::endl;
+		return false;
+	}
+	writeJSONReport(report, out);
+	return true;
+}
@@ -0,0 +1,57 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+/*
+ * Measurements of one run, written as a single JSON record (one line), so
+ * that runs can be appended to one file and compared: the wall and CPU time
+ * of each phase with the peak RSS at its end, the size of the formula, the
+ * outcome, and every statistic of the solver.
+ */
+
+#ifndef REPORT_H_
+#define REPORT_H_
+
+#include <z3++.h>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace z3;
+
+typedef struct phase_clock {
+	std::chrono::steady_clock::time_point wall;
+	double cpu; // seconds, every thread of the process
+} phase_clock;
+
+typedef struct phase_timing {
+	std::string name;
+	double wall; // seconds
+	double cpu;
+	uint64_t peakRss; // KiB, of the process up to the end of the phase
+} phase_timing;
+
+typedef struct run_report {
+	std::vector<phase_timing> phases;
+	// Values are already JSON: quoted strings or numbers
+	std::vector<std::pair<std::string, std::string> > fields;
+	std::vector<std::pair<std::string, double> > solverStatistics;
+} run_report;
+
+phase_clock startPhase();
+// Records the phase since start, and restarts the clock for the next one.
+// Does nothing without a report, so that the encoders can run without one.
+void endPhase(run_report* report, const char* name, phase_clock& start);
+
+void reportField(run_report& report, const char* key, const std::string& value);
+void reportField(run_report& report, const char* key, uint64_t value);
+void reportSolverStatistics(run_report& report, const stats& st);
+
+void writeJSONReport(run_report& report, std::ostream& out);
+// Appends the record to the file, or writes it to the standard output for "-"
+bool appendJSONReport(run_report& report, const char* path);
+
+#endif /* REPORT_H_ */
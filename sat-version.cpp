@@ -5,30 +5,53 @@
 */
 
 #include "sat-version.h"
+#include "liveness-version.h"
+#include "symmetry.h"
+#include "closure.h"
 #include <algorithm>
+#include <cassert>
+#include <cstdlib>
 
 // Internal functions : processing.
-// We only expose the launcher function and a symbol helper to the exterior, cf. header
+// We only expose the launcher function and the helpers shared with the other engines, cf. header
 
 // Utilitary functions on symbols
-std::string symbolName(node* n, rule _rule, uint32_t time);
-void addRegisteredSymbol(registered_symbol rs, symbol_list& symbols);
-expr ruleSymbol(node* n, rule _rule, uint32_t time, context& ctx, symbol_list& symbols);
-expr_vector freshBoolSymbols(node* n, rule _rule, uint32_t maxTime, context& ctx, symbol_list& symbols);
+std::string symbolName(node n, rule _rule, uint32_t time);
+uint32_t symbolSlot(node n, rule _rule, uint32_t time, symbol_table& table);
+event_window& eventWindow(node n, rule _rule, symbol_table& table);
+void computeEventWindows(run_context& run, encoding_engine engine, symbol_table& table);
+expr ruleSymbol(node n, rule _rule, uint32_t time, context& ctx, symbol_table& symbols);
+expr_vector freshBoolSymbols(node n, rule _rule, uint32_t maxTime, context& ctx, symbol_table& symbols);
 
 // DAG pre-processing : ASAP and ALAP computation
-void preProcessDAG(dag* d, uint32_t maxTime);
-void preProcessASAP(node* n, uint32_t t);
-void preProcessALAP(node* n, uint32_t t);
+bool preProcessDAG(run_context& run);
+void preProcessASAP(run_context& run, std::vector<node>& order);
+void preProcessALAP(run_context& run, std::vector<node>& order, std::vector<int64_t>& alap);
+
+// Interval disjunctions: OR of the symbols of one rule of a node over [lo, hi]
+typedef struct {
+	std::unordered_map<uint64_t, expr> intervals;
+	uint32_t nbDates;
+	bool enabled;
+} interval_cache;
+expr intervalOr(node n, rule _rule, int64_t lo, int64_t hi, context& ctx, expr_vector& constraints, symbol_table& symbols, interval_cache& cache);
 
 // Heavy functions.
-void noTwoSimultaneousNodes(expr_vector& constraints, symbol_list symbols, uint32_t maxTime, context& ctx);
-void buildConstraintsComputable(node* n, uint32_t maxTime, context& ctx, expr_vector& constraints, symbol_list& symbols);
-void buildConstraintsInput(node* n, uint32_t maxTime, context& ctx, expr_vector& constraints, symbol_list& symbols);
-void createLimitedPebbleConstraint(expr_vector& constraints, symbol_list symbols, uint32_t maxTime, uint32_t nbRedPebbles, context& ctx);
+void intervalConstraints(run_context& run, uint32_t nbRedPebbles, encoding_options& options, context& ctx, expr_vector& constraints, symbol_table& symbols);
+void noTwoSimultaneousNodes(expr_vector& constraints, symbol_list& symbols, run_context& run, amo_encoding amo, context& ctx);
+void buildConstraintsComputable(run_context& run, node n, amo_encoding amo, context& ctx, expr_vector& constraints, symbol_table& symbols, interval_cache& cache);
+void createLimitedPebbleConstraint(expr_vector& constraints, symbol_list symbols, run_context& run, uint32_t nbRedPebbles, encoding_options& options, context& ctx);
+void createPrefixPebbleConstraint(expr_vector& constraints, symbol_list& symbols, run_context& run, uint32_t nbRedPebbles, encoding_options& options, context& ctx);
+void createCardinalityPebbleConstraint(expr_vector& constraints, symbol_list& symbols, run_context& run, uint32_t nbRedPebbles, encoding_options& options, card_encoding encoding, context& ctx);
+expr registerLimitExpr(uint32_t nbRedPebbles, encoding_options& options, context& ctx, expr_vector& constraints);
+void createRegisterGuards(uint32_t nbRedPebbles, encoding_options& options, context& ctx, expr_vector& constraints);
+void createIOBudgetConstraint(expr_vector& constraints, symbol_table& symbols, uint32_t maxTime, encoding_options& options, context& ctx);
 
 //#define DEBUG
 
+const char* pebbleEncodingNames[] = { "sum", "prefix", "seqcounter", "totalizer", "sortnet" };
+const char* amoEncodingNames[] = { "pb", "pairwise", "ladder", "commander" };
+
 std::string ruleToString(rule r) {
 	switch(r) {
 		case RULE_R1:
@@ -48,56 +71,215 @@ std::string ruleToString(rule r) {
 	}
 }
 
-std::string symbolName(node* n, rule _rule, uint32_t time) {
-	return ruleToString(_rule)  + "(" + std::to_string(n->num) + "," + std::to_string(time) + ")";
+std::string symbolName(node n, rule _rule, uint32_t time) {
+	return ruleToString(_rule)  + "(" + std::to_string(n + 1) + "," + std::to_string(time) + ")";
 }
 
-registered_symbol lookupRegisteredSymbol(std::string name, symbol_list& symbols) {
-	std::vector<registered_symbol>::iterator i;
-	for(i = symbols.begin();
-				(i < symbols.end()) ; ++i) {
-		std::string symName = symbolName(i->n, i->r, i->date);
-		if(symName == name)
-			break;
+void initSymbolTable(const dag* _dag, uint32_t maxTime, symbol_table& table) {
+	// Dates go up to maxTime included: output nodes have their ALAP at maxTime.
+	table.nbNodes = _dag->nbNodes;
+	table.nbDates = maxTime + 1;
+	table.symbols.clear();
+	table.decls.clear();
+	table.slots.assign((size_t)table.nbNodes * RULE_R4 * table.nbDates, NO_SYMBOL);
+	event_window whole = { 0, maxTime };
+	table.windows.assign((size_t)table.nbNodes * RULE_R4, whole);
+}
+
+event_window& eventWindow(node n, rule _rule, symbol_table& table) {
+	return table.windows[(size_t)n * RULE_R4 + (_rule - RULE_R1)];
+}
+
+// Windows that every schedule without useless events fits in, from ASAP and
+// ALAP:
+// - R3 in [ASAP, ALAP], none for inputs;
+// - R1 after the node is computed, i.e. from ASAP + 1, and before the ALAP
+//   of its last successor; outputs are never loaded back;
+// - R2 once the node is in a register, and before the ALAP of its last
+//   successor unless it is an output;
+// - R4 deletes for good, so only after the ASAP of every successor; outputs
+//   must stay in memory.
+// The R2 and R4 windows only hold in the liveness game. The interval engine's
+// running register count can use a spill or a delete before the node is
+// computed, so there they cover the whole horizon.
+void computeEventWindows(run_context& run, encoding_engine engine, symbol_table& table) {
+	const dag* _dag = run.graph;
+	uint32_t maxTime = run.maxTime;
+	int64_t lastDate = (int64_t)maxTime - 1; // last date with an event
+	for(node n = 0; n < _dag->nbNodes; ++n) {
+		bool input = nbPredecessors(_dag, n) == 0;
+		bool output = nbSuccessors(_dag, n) == 0;
+		int64_t maxSuccAsap = -1, maxSuccAlap = -1;
+		for(uint32_t i = 0; i < nbSuccessors(_dag, n); ++i) {
+			node s = successors(_dag, n)[i];
+			maxSuccAsap = std::max(maxSuccAsap, (int64_t)run.asap[s]);
+			maxSuccAlap = std::max(maxSuccAlap, (int64_t)run.alap[s]);
+		}
+
+		int64_t asap = run.asap[n];
+		int64_t bounds[RULE_R4][2] = {
+			{ input ? 0 : asap + 1, output ? -1 : maxSuccAlap - 1 },
+			{ input ? 1 : asap + 1, output ? (input ? -1 : lastDate) : maxSuccAlap - 1 },
+			{ asap, input ? -1 : (int64_t)run.alap[n] },
+			{ maxSuccAsap + 1, output ? -1 : lastDate }
+		};
+		for(uint32_t r = 0; r < RULE_R4; ++r) {
+			rule _rule = (rule)(RULE_R1 + r);
+			if(engine == ENGINE_INTERVAL && (_rule == RULE_R2 || _rule == RULE_R4))
+				continue;
+			event_window& w = eventWindow(n, _rule, table);
+			int64_t first = std::max(bounds[r][0], (int64_t)0);
+			int64_t last = std::min(bounds[r][1], (int64_t)maxTime);
+			if(first > last) {
+				w.first = 1; // empty
+				w.last = 0;
+			} else {
+				w.first = (uint32_t)first;
+				w.last = (uint32_t)last;
+			}
+		}
 	}
+}
 
-	if(i < symbols.end())
-		return *i;
+uint32_t symbolSlot(node n, rule _rule, uint32_t time, symbol_table& table) {
+	// An indexing bug, not a property of the instance: stop rather than solve
+	// a formula with constraints missing
+	if(n >= table.nbNodes || _rule < RULE_R1 || _rule > RULE_R4 || time >= table.nbDates) {
+		std::cerr << "Symbol out of the table: " << symbolName(n, _rule, time) << std::endl;
+		abort();
+	}
+	// NONE is not stored
+	return ((size_t)n * RULE_R4 + (_rule - RULE_R1)) * table.nbDates + time;
+}
+
+registered_symbol* findRegisteredSymbol(node n, rule r, uint32_t date, symbol_table& table) {
+	uint32_t id = table.slots[symbolSlot(n, r, date, table)];
+	if(id == NO_SYMBOL)
+		return NULL;
+	return &(table.symbols[id]);
+}
 
-	std::string err = "Symbol not found: " + name;
-	throw exception(err.c_str());
+registered_symbol* findRegisteredDecl(func_decl& decl, symbol_table& table) {
+	std::unordered_map<unsigned, uint32_t>::iterator i = table.decls.find(decl.id());
+	if(i == table.decls.end())
+		return NULL;
+	return &(table.symbols[i->second]);
 }
 
-void addRegisteredSymbol(registered_symbol rs, symbol_list& symbols) {
-	std::vector<registered_symbol>::iterator i;
-	for(i = symbols.begin();
-			(i < symbols.end()) && (rs.n != i->n || rs.r != i->r || rs.date != i->date); ++i) {
+registered_symbol& addRegisteredSymbol(registered_symbol rs, symbol_table& table) {
+	uint32_t& slot = table.slots[symbolSlot(rs.n, rs.r, rs.date, table)];
+	if(slot == NO_SYMBOL) {
+		slot = table.symbols.size();
+		rs.id = slot;
+		table.symbols.push_back(rs);
+		table.decls[rs.symbol.decl().id()] = slot;
 	}
-	if(i == symbols.end()) {
-		symbols.push_back(rs);
+	return table.symbols[slot];
+}
+
+// Implied by some R3 of n up to date t. Only this direction is needed: the
+// lemmas that use it only require "computed by t", they never forbid it.
+expr computedBy(node n, uint32_t t, context& ctx, expr_vector& constraints, symbol_table& symbols,
+		prefix_cache& prefixes) {
+	uint64_t key = (uint64_t)n * symbols.nbDates + t;
+	prefix_cache::iterator i = prefixes.find(key);
+	if(i != prefixes.end())
+		return i->second;
+
+	expr before = t > 0 ? computedBy(n, t - 1, ctx, constraints, symbols, prefixes) : ctx.bool_val(false);
+	registered_symbol* compute = findRegisteredSymbol(n, RULE_R3, t, symbols);
+	expr ret = before;
+	if(compute != NULL) {
+		ret = ctx.bool_const(("computed_by(" + std::to_string(n + 1) + "," + std::to_string(t) + ")").c_str());
+		constraints.push_back(implies(ret, before || compute->symbol));
 	}
+	prefixes.insert(std::make_pair(key, ret));
+	return ret;
 }
 
-expr ruleSymbol(node* n, rule _rule, uint32_t time, context& ctx, symbol_list& symbols) {
+expr ruleSymbol(node n, rule _rule, uint32_t time, context& ctx, symbol_table& symbols) {
+	// Already created: no name formatting, no search
+	event_window& w = eventWindow(n, _rule, symbols);
+	if(time < w.first || time > w.last)
+		return ctx.bool_val(false);
+	registered_symbol* existing = findRegisteredSymbol(n, _rule, time, symbols);
+	if(existing != NULL)
+		return existing->symbol;
+
 	expr ret =  ctx.bool_const(symbolName(n, _rule, time).c_str());
-	registered_symbol rsym = { ret, n, _rule, time };
+	registered_symbol rsym = { ret, n, _rule, time, NO_SYMBOL };
 	addRegisteredSymbol(rsym, symbols);
 	return ret;
 }
 
-expr_vector freshBoolSymbols(node* n, rule _rule, uint32_t maxTime, context& ctx, symbol_list& symbols) {
+expr_vector freshBoolSymbols(node n, rule _rule, uint32_t maxTime, context& ctx, symbol_table& symbols) {
 	expr_vector ret(ctx);
 	uint32_t t;
 	for(t = 0; t < maxTime; ++t) {
-		std::string sn = symbolName(n, _rule, t);
-		expr sym = ctx.bool_const(sn.c_str());
-		registered_symbol rsym = { sym, n, _rule, t };
-		addRegisteredSymbol(rsym, symbols);
-		ret.push_back(sym);
+		ret.push_back(ruleSymbol(n, _rule, t, ctx, symbols));
+	}
+	return ret;
+}
+
+schedule decodeModel(model& m, uint32_t maxTime, symbol_table& table) {
+	schedule_event idle = { NO_NODE, NONE };
+	schedule ret(maxTime, idle);
+
+	for(uint32_t i = 0; i < m.num_consts(); ++i) {
+		func_decl decl = m.get_const_decl(i);
+		registered_symbol* sym = findRegisteredDecl(decl, table);
+		if(sym == NULL || sym->date >= maxTime)
+			continue; // auxiliary variable, or past the horizon
+
+		expr body = m.get_const_interp(decl);
+		if(body.is_bool() && body.bool_value() == Z3_L_TRUE) {
+			if(ret[sym->date].n != NO_NODE) {
+				std::cout << "WARNING: two events at date " << std::to_string(sym->date) << ", keeping the first one" << std::endl;
+				continue;
+			}
+			ret[sym->date].n = sym->n;
+			ret[sym->date].r = sym->r;
+		}
 	}
+
 	return ret;
 }
 
+// The same windows come back for every t, tt and ttt in buildConstraintsComputable.
+// Each [lo, hi] gets one auxiliary Boolean, defined once as [lo, hi-1] OR symbol(hi):
+// intervals sharing their lower bound form a chain, so each one costs O(1).
+expr intervalOr(node n, rule _rule, int64_t lo, int64_t hi, context& ctx, expr_vector& constraints, symbol_table& symbols, interval_cache& cache) {
+	// Only the dates of the window have a symbol
+	event_window& w = eventWindow(n, _rule, symbols);
+	lo = std::max(lo, (int64_t)w.first);
+	hi = std::min(hi, (int64_t)w.last);
+	if(lo > hi)
+		return ctx.bool_val(false); // mk_or of nothing
+	if(lo == hi)
+		return ruleSymbol(n, _rule, lo, ctx, symbols);
+
+	if(!cache.enabled) {
+		expr_vector interval_v(ctx);
+		for(int64_t t = lo; t <= hi; ++t)
+			interval_v.push_back(ruleSymbol(n, _rule, t, ctx, symbols));
+		return mk_or(interval_v);
+	}
+
+	uint64_t key = (((uint64_t)n * RULE_R4 + (_rule - RULE_R1)) * cache.nbDates + lo) * cache.nbDates + hi;
+	std::unordered_map<uint64_t, expr>::iterator i = cache.intervals.find(key);
+	if(i != cache.intervals.end())
+		return i->second;
+
+	expr shorter = intervalOr(n, _rule, lo, hi - 1, ctx, constraints, symbols, cache);
+	expr last = ruleSymbol(n, _rule, hi, ctx, symbols);
+	std::string name = "any_" + ruleToString(_rule) + "(" + std::to_string(n + 1) + ","
+			+ std::to_string(lo) + "," + std::to_string(hi) + ")";
+	expr any = ctx.bool_const(name.c_str());
+	constraints.push_back(any == (shorter || last));
+	cache.intervals.insert(std::make_pair(key, any));
+	return any;
+}
+
 //// ARCHITECTURE: express the limited number of pebbles
 
 bool compareSymbolsByDate(registered_symbol a, registered_symbol b) {
@@ -106,7 +288,7 @@ bool compareSymbolsByDate(registered_symbol a, registered_symbol b) {
 
 // This one should yield a pretty big structure. This is actually one of the reasons why
 // no compilers perform simultaneous scheduling and register allocation.
-void createLimitedPebbleConstraint(expr_vector& constraints, symbol_list symbols, uint32_t maxTime, uint32_t nbRedPebbles, context& ctx) {
+void createLimitedPebbleConstraint(expr_vector& constraints, symbol_list symbols, run_context& run, uint32_t nbRedPebbles, encoding_options& options, context& ctx) {
 	// for all t's before maxTime
 	// sum those symbols with epsilons
 	// impose the result must not exceed the number of red pebbles
@@ -114,6 +296,7 @@ void createLimitedPebbleConstraint(expr_vector& constraints, symbol_list symbols
 	// Sort by date
 	std::sort(symbols.begin(), symbols.end(), compareSymbolsByDate);
 
+	uint32_t maxTime = run.maxTime;
 	uint32_t t;
 	expr r1val = ctx.int_val(1);
 	expr r2val = ctx.int_val(-1);
@@ -121,7 +304,7 @@ void createLimitedPebbleConstraint(expr_vector& constraints, symbol_list symbols
 	expr r4val = ctx.int_val(-1);
 	expr zero = ctx.int_val(0);
 
-	expr redPebblesExpr = ctx.int_val(nbRedPebbles);
+	expr redPebblesExpr = registerLimitExpr(nbRedPebbles, options, ctx, constraints);
 
 	for(t = 0; t < maxTime; ++t) {
 
@@ -148,17 +331,165 @@ void createLimitedPebbleConstraint(expr_vector& constraints, symbol_list symbols
 		expr constraintOnPebbles = (takenPebblesAtDateT <= redPebblesExpr);
 		//std::cout << constraintOnPebbles << std::endl;
 		constraints.push_back(constraintOnPebbles);
+		flushConstraints(run, constraints);
 	}
 }
 
+// Same constraint, but the number of live pebbles at t is an integer variable defined
+// from the one at t-1 and the events at t, so that the formula grows linearly with the horizon.
+void createPrefixPebbleConstraint(expr_vector& constraints, symbol_list& symbols, run_context& run, uint32_t nbRedPebbles, encoding_options& options, context& ctx) {
+	uint32_t maxTime = run.maxTime;
+	expr one = ctx.int_val(1);
+	expr minusOne = ctx.int_val(-1);
+	expr zero = ctx.int_val(0);
+
+	expr redPebblesExpr = registerLimitExpr(nbRedPebbles, options, ctx, constraints);
+
+	// Bucket the events by date
+	std::vector<expr_vector> eventsAtT;
+	for(uint32_t t = 0; t < maxTime; ++t)
+		eventsAtT.push_back(expr_vector(ctx));
+	for(symbol_list::iterator i = symbols.begin(); i < symbols.end(); ++i) {
+		if(i->date >= maxTime)
+			continue;
+		switch(i->r) {
+		case RULE_R1:
+		case RULE_R3:
+			eventsAtT[i->date].push_back(ite(i->symbol, one, zero));
+			break;
+		case RULE_R2:
+		case RULE_R4:
+			eventsAtT[i->date].push_back(ite(i->symbol, minusOne, zero));
+			break;
+		default:
+			break;
+		}
+	}
+
+	expr livePebbles = zero;
+	for(uint32_t t = 0; t < maxTime; ++t) {
+		expr livePebblesAtT = ctx.int_const(("live(" + std::to_string(t) + ")").c_str());
+		if(eventsAtT[t].size() > 0)
+			constraints.push_back(livePebblesAtT == livePebbles + sum(eventsAtT[t]));
+		else
+			constraints.push_back(livePebblesAtT == livePebbles);
+		constraints.push_back(livePebblesAtT <= redPebblesExpr);
+		flushConstraints(run, constraints);
+		livePebbles = livePebblesAtT;
+	}
+}
+
+// Pure CNF version. Since at most one event happens at each date, the events at t
+// add up to inc(t) - dec(t), with inc(t) the OR of the R1/R3 at t and dec(t) the OR of the R2/R4.
+// Then live(t) <= k  <=>  sum(inc(t'), t' <= t) + sum(!dec(t'), t' <= t) <= k + t + 1,
+// which is an at-most-k over the prefix of the sequence inc(0), !dec(0), inc(1), !dec(1)...
+void createCardinalityPebbleConstraint(expr_vector& constraints, symbol_list& symbols, run_context& run, uint32_t nbRedPebbles, encoding_options& options, card_encoding encoding, context& ctx) {
+	uint32_t maxTime = run.maxTime;
+	std::vector<expr_vector> incAtT, decAtT;
+	for(uint32_t t = 0; t < maxTime; ++t) {
+		incAtT.push_back(expr_vector(ctx));
+		decAtT.push_back(expr_vector(ctx));
+	}
+	for(symbol_list::iterator i = symbols.begin(); i < symbols.end(); ++i) {
+		if(i->date >= maxTime)
+			continue;
+		if(i->r == RULE_R1 || i->r == RULE_R3)
+			incAtT[i->date].push_back(i->symbol);
+		else if(i->r == RULE_R2 || i->r == RULE_R4)
+			decAtT[i->date].push_back(i->symbol);
+	}
+
+	expr_vector literals(ctx);
+	for(uint32_t t = 0; t < maxTime; ++t) {
+		literals.push_back(mk_or(incAtT[t]));
+		literals.push_back(!mk_or(decAtT[t]));
+	}
+
+	// One counter serves every prefix, a row per date, built in one go
+	std::vector<expr_vector> rows = prefixCounters(literals, 2, nbRedPebbles + maxTime + 1, encoding, ctx, constraints);
+	for(uint32_t t = 0; t < maxTime; ++t) {
+		boundUnaryCount(rows[t], t + 1, nbRedPebbles, options, ctx, constraints);
+		flushConstraints(run, constraints);
+	}
+}
+
+//// REGISTER COUNT: constant, or chosen at check time
+
+expr registerGuard(uint32_t k, context& ctx) {
+	return ctx.bool_const(("registers_le(" + std::to_string(k) + ")").c_str());
+}
+
+bool symbolicRegisters(uint32_t nbRedPebbles, encoding_options& options) {
+	return options.minRegisters < nbRedPebbles;
+}
+
+void createRegisterGuards(uint32_t nbRedPebbles, encoding_options& options, context& ctx, expr_vector& constraints) {
+	for(uint32_t k = options.minRegisters; k < nbRedPebbles; ++k)
+		constraints.push_back(!registerGuard(k, ctx) || registerGuard(k + 1, ctx));
+	constraints.push_back(registerGuard(nbRedPebbles, ctx));
+}
+
+// For the integer encodings: a constant, or a variable bounded by the guards
+expr registerLimitExpr(uint32_t nbRedPebbles, encoding_options& options, context& ctx, expr_vector& constraints) {
+	if(!symbolicRegisters(nbRedPebbles, options))
+		return ctx.int_val(nbRedPebbles);
+
+	expr registers = ctx.int_const("registers");
+	for(uint32_t k = options.minRegisters; k <= nbRedPebbles; ++k)
+		constraints.push_back(implies(registerGuard(k, ctx), registers <= ctx.int_val(k)));
+	return registers;
+}
+
+void boundUnaryCount(expr_vector& count, uint32_t offset, uint32_t nbRedPebbles, encoding_options& options, context& ctx, expr_vector& constraints) {
+	if(!symbolicRegisters(nbRedPebbles, options)) {
+		if(offset + nbRedPebbles < count.size())
+			constraints.push_back(!count[offset + nbRedPebbles]);
+		return;
+	}
+	for(uint32_t k = options.minRegisters; k <= nbRedPebbles; ++k) {
+		if(offset + k < count.size())
+			constraints.push_back(!registerGuard(k, ctx) || !count[offset + k]);
+	}
+}
+
+expr_vector ioSymbols(symbol_table& symbols, uint32_t maxTime, context& ctx) {
+	expr_vector ret(ctx);
+	for(symbol_list::iterator i = symbols.symbols.begin(); i < symbols.symbols.end(); ++i) {
+		if(i->date < maxTime && (i->r == RULE_R1 || i->r == RULE_R2))
+			ret.push_back(i->symbol);
+	}
+	return ret;
+}
+
+card_encoding cardEncoding(pebble_encoding pebbles) {
+	switch(pebbles) {
+	case PEBBLES_TOTALIZER:
+		return CARD_TOTALIZER;
+	case PEBBLES_SORTING_NETWORK:
+		return CARD_SORTING_NETWORK;
+	default:
+		return CARD_SEQUENTIAL_COUNTER;
+	}
+}
+
+// The I/O budget, independently of the horizon: count the loads and stores.
+void createIOBudgetConstraint(expr_vector& constraints, symbol_table& symbols, uint32_t maxTime, encoding_options& options, context& ctx) {
+	expr_vector io = ioSymbols(symbols, maxTime, ctx);
+	if(isPureBoolean(options))
+		atMostK(io, options.ioBudget, cardEncoding(options.pebbles), ctx, constraints);
+	else if(io.size() > options.ioBudget)
+		constraints.push_back(atmost(io, options.ioBudget));
+}
+
 //// SCHEDULING: express the scheduling problem, respecting the dependences
 
-void noTwoSimultaneousNodes(expr_vector& constraints, symbol_list symbols, uint32_t maxTime, context& ctx) {
+void noTwoSimultaneousNodes(expr_vector& constraints, symbol_list& symbols, run_context& run, amo_encoding amo, context& ctx) {
 	// Symbols are our xi's (in the paper). This function makes them mutually exclusive by date,
 	// i.e. no two operations can happen at the same time. This makes a lot of constraints, but it's
 	// essential so that we can count the spills and restores.
 
 
+	uint32_t maxTime = run.maxTime;
 	uint32_t t;
 	for(t = 0; t < maxTime; ++t) {
 		expr_vector possibleOpsAtT(ctx);
@@ -169,34 +500,36 @@ void noTwoSimultaneousNodes(expr_vector& constraints, symbol_list symbols, uint3
 				possibleOpsAtT.push_back(i->symbol);
 		}
 		// Makeshift XOR : "atmost" one should be true.
-		expr oneOnlyAtT = atmost(possibleOpsAtT, 1);
-		constraints.push_back(oneOnlyAtT);
+		atMostOne(possibleOpsAtT, amo, ctx, constraints);
+		flushConstraints(run, constraints);
 	}
 
 }
 
 
 
-void buildConstraintsComputable(node* n, uint32_t maxTime, context& ctx, expr_vector& constraints, symbol_list& symbols) {
+void buildConstraintsComputable(run_context& run, node n, amo_encoding amo, context& ctx, expr_vector& constraints, symbol_table& symbols, interval_cache& cache) {
 	// For each node, its dependences must have been computed before it is.
+	const dag* _dag = run.graph;
+	uint32_t maxTime = run.maxTime;
 
 	uint32_t i;
-	uint32_t t, tt, ttt, tttt;
+	uint32_t t, tt, ttt;
 
 	try {
 		expr_vector constraintsToScheduleNodeAtT(ctx);
-		for(t = n->asap; t <= n->alap; ++t) {
+		for(t = run.asap[n]; t <= run.alap[n]; ++t) {
 
 			// There must be an R3 at some time.
 			// We have to do it after all the dependencies are satisfied.
 			expr computeAtT = ruleSymbol(n, RULE_R3, t, ctx, symbols);
 #ifdef DEBUG
-			std::cout <<  "Node " << std::to_string(n->num) << " is computed at date " << std::to_string(t) << std::endl;
+			std::cout <<  "Node " << std::to_string(n + 1) << " is computed at date " << std::to_string(t) << std::endl;
 #endif
 			expr_vector constraintsOnPredecessors(ctx);
 
-			for(i = 0; i < n->nbPredecessors; ++i) {
-				node* predecessor = n->predecessors[i];
+			for(i = 0; i < nbPredecessors(_dag, n); ++i) {
+				node predecessor = predecessors(_dag, n)[i];
 				// If we are computing this node at time t, then:
 				// - this predecessor must have been computed or loaded (be in memory)
 				// - it musn't have been spilled since then
@@ -205,41 +538,29 @@ void buildConstraintsComputable(node* n, uint32_t maxTime, context& ctx, expr_ve
 				//                                     AND (do not spill between t and t')
 				expr_vector P3OrP4_v(ctx);
 
-				for(tt = predecessor->asap; tt < t; ++tt) {
+				for(tt = run.asap[predecessor]; tt < t; ++tt) {
 
 					// Common to P3 and P4 - load at date t (mandatory for P3, will be ORed for P4)
 					// This R1 may come from a spill OR from a pure load (input)
 
 					// Dependence is an intermediary node: Verify P4
-					if(predecessor->nbPredecessors > 0) {
+					if(nbPredecessors(_dag, predecessor) > 0) {
 						expr scheduleLoadAtTT = ruleSymbol(predecessor, RULE_R1, tt, ctx, symbols);
 						expr scheduleComputeAtTT = ruleSymbol(predecessor, RULE_R3, tt, ctx, symbols);
 
 
 						expr_vector computeDepStrictlyBeforeTT_v(ctx);
-						for(ttt = predecessor->asap; ttt < tt; ++ttt) {
+						for(ttt = run.asap[predecessor]; ttt < tt; ++ttt) {
 							// If loaded at date tt, then has been computed at date ttt < tt.
 							expr computePredecessorAtTTT = ruleSymbol(predecessor, RULE_R3, ttt, ctx, symbols);
 							// the predecessor must not be deleted between ttt and t.
-							expr_vector deleteBetweenTTTAndT_v(ctx);
-							for(tttt = ttt; tttt <= t; ++tttt) {
-								deleteBetweenTTTAndT_v.push_back(ruleSymbol(predecessor, RULE_R4, tttt, ctx, symbols));
-							}
-							expr doNotDeleteBetweenTTTAndTT = not(mk_or(deleteBetweenTTTAndT_v));
+							expr doNotDeleteBetweenTTTAndTT = not(intervalOr(predecessor, RULE_R4, ttt, t, ctx, constraints, symbols, cache));
 							computeDepStrictlyBeforeTT_v.push_back(computePredecessorAtTTT && doNotDeleteBetweenTTTAndTT);
 						}
 
 						// There exists a ttt < tt such that dependence computed at ttt
 						expr computeDepStrictlyBeforeTT = mk_or(computeDepStrictlyBeforeTT_v);
 
-						// No storeback between tt and t
-						expr_vector spillsBetweenTTAndT(ctx);
-						for(ttt = tt; ttt <= t; ++ttt) {
-							expr spillAtTTT = ruleSymbol(predecessor, RULE_R2, ttt, ctx, symbols);
-							spillsBetweenTTAndT.push_back(spillAtTTT);
-						}
-						expr noSpillsBetweenTTAndT = not(mk_or(spillsBetweenTTAndT));
-
 						expr P4 = (scheduleLoadAtTT && computeDepStrictlyBeforeTT) || scheduleComputeAtTT;
 						P3OrP4_v.push_back(P4);
 
@@ -250,11 +571,7 @@ void buildConstraintsComputable(node* n, uint32_t maxTime, context& ctx, expr_ve
 						expr scheduleLoadAtTT = ruleSymbol(predecessor, RULE_R1, tt, ctx, symbols);
 
 						// no delete before t
-						expr_vector deleteBeforeT_v(ctx);
-						for(ttt = 0; ttt < t; ++ttt) {
-							deleteBeforeT_v.push_back(ruleSymbol(predecessor, RULE_R4, ttt, ctx, symbols));
-						}
-						expr doNotDeleteBeforeT = not(mk_or(deleteBeforeT_v));
+						expr doNotDeleteBeforeT = not(intervalOr(predecessor, RULE_R4, 0, (int64_t)t - 1, ctx, constraints, symbols, cache));
 
 						expr P3 = scheduleLoadAtTT && doNotDeleteBeforeT;
 						P3OrP4_v.push_back(P3);
@@ -265,11 +582,7 @@ void buildConstraintsComputable(node* n, uint32_t maxTime, context& ctx, expr_ve
 				expr P3OrP4 = mk_or(P3OrP4_v);
 
 				// Schedule deletion - P5
-				expr_vector deleteAfterT_v(ctx);
-				for(ttt = t+1; ttt < maxTime; ++ttt) {
-					deleteAfterT_v.push_back(ruleSymbol(predecessor, RULE_R4, ttt, ctx, symbols));
-				}
-				expr P5 = mk_or(deleteAfterT_v);
+				expr P5 = intervalOr(predecessor, RULE_R4, t + 1, (int64_t)maxTime - 1, ctx, constraints, symbols, cache);
 
 				constraintsOnPredecessors.push_back(P3OrP4 && P5);
 
@@ -278,13 +591,8 @@ void buildConstraintsComputable(node* n, uint32_t maxTime, context& ctx, expr_ve
 			// Are we scheduling an output node ? In this case, we'll store it.
 			// Otherwise, we'll end up deleting it, but this will be handled by a successor.
 			expr storeAfterT = ctx.bool_val(true); // no constraint if not output node
-			if(n->nbSuccessors == 0) {
-				expr_vector storeAfterT_v(ctx);
-				for(tt = t+1; tt < maxTime; ++tt) {
-					expr storeAtTT = ruleSymbol(n, RULE_R2, tt, ctx, symbols);
-					storeAfterT_v.push_back(storeAtTT);
-				}
-				storeAfterT = mk_or(storeAfterT_v);
+			if(nbSuccessors(_dag, n) == 0) {
+				storeAfterT = intervalOr(n, RULE_R2, t + 1, (int64_t)maxTime - 1, ctx, constraints, symbols, cache);
 			}
 			// Compute current node at date t, given all the scheduling constraints above on predecessors
 			constraintsToScheduleNodeAtT.push_back(computeAtT && mk_and(constraintsOnPredecessors) && storeAfterT);
@@ -292,87 +600,234 @@ void buildConstraintsComputable(node* n, uint32_t maxTime, context& ctx, expr_ve
 		}
 		// This OR models that we'll end up scheduling this node. This is the first part of P1 or P2. Predecessors have been taken care of already.
 		constraints.push_back(mk_or(constraintsToScheduleNodeAtT));
-		constraints.push_back(atmost(constraintsToScheduleNodeAtT, 1));
+		atMostOne(constraintsToScheduleNodeAtT, amo, ctx, constraints);
 
-	} catch(exception e) {
+	} catch(exception& e) {
+		// The node's constraints are incomplete: the formula can't be solved
 		std::cout << e.msg() << std::endl;
+		throw;
 	}
 
 }
 
-void dagToConstraints(dag* _dag, uint32_t nbRedPebbles, uint32_t maxTime, context& ctx, expr_vector& constraints, symbol_list& symbols) {
+void flushConstraints(run_context& run, expr_vector& constraints) {
+	if(run.sink != NULL)
+		writeConstraints(*run.sink, constraints);
+}
+
+bool dagToConstraints(const dag* _dag, uint32_t nbRedPebbles, uint32_t maxTime, encoding_options& options, context& ctx, expr_vector& constraints, symbol_table& symbols,
+		run_report* report, constraint_sink* sink) {
 	std::cout << "## Pre-processing DAG: computing ASAP, ALAP" << std::endl;
-	preProcessDAG(_dag, maxTime);
+	phase_clock clock = startPhase();
+	run_context run;
+	run.graph = _dag;
+	run.maxTime = maxTime;
+	run.report = report;
+	run.sink = sink;
+	bool feasible = preProcessDAG(run);
+	initSymbolTable(_dag, maxTime, symbols);
+	if(!feasible) {
+		constraints.push_back(ctx.bool_val(false));
+		flushConstraints(run, constraints);
+		endPhase(report, "asap_alap", clock);
+		return false;
+	}
+	if(options.eventWindows)
+		computeEventWindows(run, options.engine, symbols);
+	endPhase(report, "asap_alap", clock);
+
+	if(symbolicRegisters(nbRedPebbles, options)) {
+		createRegisterGuards(nbRedPebbles, options, ctx, constraints);
+		flushConstraints(run, constraints);
+		endPhase(report, "register_guards", clock);
+	}
+
+	if(options.engine == ENGINE_LIVENESS)
+		livenessConstraints(run, nbRedPebbles, options, ctx, constraints, symbols);
+	else
+		intervalConstraints(run, nbRedPebbles, options, ctx, constraints, symbols);
+	clock = startPhase();
+
+	prefix_cache prefixes;
+	if(options.orderingLemmas) {
+		reach_closure closure;
+		if(reachabilityClosure(_dag, closure)) {
+			uint64_t nbLemmas = orderingLemmas(run, closure, ctx, constraints, symbols, prefixes);
+			std::cout << "## Built " << std::to_string(nbLemmas) << " ordering and incompatibility lemmas" << std::endl;
+		} else {
+			std::cout << "## No ordering lemmas: more than " << std::to_string(CLOSURE_MAX_NODES) << " nodes" << std::endl;
+		}
+		flushConstraints(run, constraints);
+		endPhase(report, "ordering_lemmas", clock);
+	}
+
+	if(options.symmetryBreaking) {
+		uint64_t budget = SYMMETRY_SEARCH_BUDGET;
+		std::vector<permutation> generators = dagAutomorphisms(_dag, budget);
+		std::cout << "## Building symmetry-breaking constraints for " << std::to_string(generators.size())
+				<< " automorphisms" << (budget == 0 ? " (search budget exhausted)" : "") << std::endl;
+		symmetryBreakingConstraints(_dag, generators, maxTime, ctx, constraints, symbols, prefixes);
+		flushConstraints(run, constraints);
+		endPhase(report, "symmetry_breaking", clock);
+	}
+
+	if(options.ioBudget != NO_IO_BUDGET) {
+		std::cout << "## Building I/O budget constraint" << std::endl;
+		createIOBudgetConstraint(constraints, symbols, maxTime, options, ctx);
+		flushConstraints(run, constraints);
+		endPhase(report, "io_budget", clock);
+	}
+	return true;
+}
 
+void intervalConstraints(run_context& run, uint32_t nbRedPebbles, encoding_options& options, context& ctx, expr_vector& constraints, symbol_table& symbols) {
+	const dag* _dag = run.graph;
 	std::cout << "## Building individual constraints for dependences and computation" << std::endl;
+	phase_clock clock = startPhase();
 	uint32_t i;
-	node* n;
+	interval_cache cache;
+	cache.nbDates = symbols.nbDates;
+	cache.enabled = options.intervalCache;
 	for(i = 0; i < _dag->nbNodes; ++i) {
-		n = &(_dag->allNodes[i]);
-		if(n->nbPredecessors > 0) {
-			std::cout << "### Processing node " << std::to_string(n->num) << std::endl;
-			buildConstraintsComputable(n, maxTime, ctx, constraints, symbols);
+		if(nbPredecessors(_dag, i) > 0) {
+			std::cout << "### Processing node " << std::to_string(i + 1) << std::endl;
+			buildConstraintsComputable(run, i, options.amo, ctx, constraints, symbols, cache);
+			flushConstraints(run, constraints);
 		}
 	}
 
+	endPhase(run.report, "dependences", clock);
+
 	std::cout << "## Building sequentiality constraints" << std::endl;
-	noTwoSimultaneousNodes(constraints, symbols, maxTime, ctx);
+	noTwoSimultaneousNodes(constraints, symbols.symbols, run, options.amo, ctx);
+	flushConstraints(run, constraints);
+	endPhase(run.report, "sequentiality", clock);
 
 	std::cout << "## Building architectural constraints" << std::endl;
-	createLimitedPebbleConstraint(constraints, symbols, maxTime, nbRedPebbles, ctx);
+	switch(options.pebbles) {
+	case PEBBLES_PREFIX:
+		createPrefixPebbleConstraint(constraints, symbols.symbols, run, nbRedPebbles, options, ctx);
+		break;
+	case PEBBLES_SEQUENTIAL_COUNTER:
+		createCardinalityPebbleConstraint(constraints, symbols.symbols, run, nbRedPebbles, options, CARD_SEQUENTIAL_COUNTER, ctx);
+		break;
+	case PEBBLES_TOTALIZER:
+		createCardinalityPebbleConstraint(constraints, symbols.symbols, run, nbRedPebbles, options, CARD_TOTALIZER, ctx);
+		break;
+	case PEBBLES_SORTING_NETWORK:
+		createCardinalityPebbleConstraint(constraints, symbols.symbols, run, nbRedPebbles, options, CARD_SORTING_NETWORK, ctx);
+		break;
+	case PEBBLES_SUM:
+	default:
+		createLimitedPebbleConstraint(constraints, symbols.symbols, run, nbRedPebbles, options, ctx);
+	}
+	flushConstraints(run, constraints);
+	endPhase(run.report, "architectural", clock);
+}
+
+bool isPureBoolean(encoding_options& options) {
+	return options.amo != AMO_PB
+		&& options.pebbles != PEBBLES_SUM && options.pebbles != PEBBLES_PREFIX;
+}
 
+uint64_t formulaSize(expr_vector& constraints, uint64_t* nbVariables) {
+	// Iterative DFS over the term DAG, each term visited once
+	if(nbVariables != NULL)
+		*nbVariables = 0;
+	std::unordered_map<unsigned, bool> visited;
+	std::vector<expr> todo;
+	for(unsigned i = 0; i < constraints.size(); ++i)
+		todo.push_back(constraints[i]);
+
+	while(!todo.empty()) {
+		expr e = todo.back();
+		todo.pop_back();
+		if(visited.count(e.id()) > 0)
+			continue;
+		visited[e.id()] = true;
+		if(nbVariables != NULL && e.is_const() && e.decl().decl_kind() == Z3_OP_UNINTERPRETED)
+			*nbVariables += 1;
+		if(e.is_app()) {
+			for(unsigned i = 0; i < e.num_args(); ++i)
+				todo.push_back(e.arg(i));
+		}
+	}
+	return visited.size();
 }
 
 
 
 /// OPTIMIZATION : Pre-process the DAG to compute nodes mobility
 
-void preProcessASAP(node* n) {
-	if(n->nbPredecessors > 0) {
-		uint32_t minPredAsap = UINT32_MAX;
-		uint32_t maxPredAsap = 0;
-		for(uint32_t i = 0; i < n->nbPredecessors; ++i) {
-			preProcessASAP(n->predecessors[i]);//, t+1);
-			minPredAsap = std::min(minPredAsap, n->predecessors[i]->asap);
-			maxPredAsap = std::max(maxPredAsap, n->predecessors[i]->asap);
-		}
-
-		n->asap = std::max(minPredAsap + n->nbPredecessors, 1 + maxPredAsap);
-	} else n->asap = 0;
+// Both passes follow a topological order, so that each edge is looked at once.
+void preProcessASAP(run_context& run, std::vector<node>& order) {
+	const dag* d = run.graph;
+	for(uint32_t i = 0; i < d->nbNodes; ++i) {
+		node n = order[i];
+		uint32_t nbPreds = nbPredecessors(d, n);
+		const node* preds = predecessors(d, n);
+		if(nbPreds > 0) {
+			uint64_t minPredAsap = UINT32_MAX;
+			uint64_t maxPredAsap = 0;
+			for(uint32_t k = 0; k < nbPreds; ++k) {
+				minPredAsap = std::min(minPredAsap, (uint64_t)run.asap[preds[k]]);
+				maxPredAsap = std::max(maxPredAsap, (uint64_t)run.asap[preds[k]]);
+			}
+			// Saturates, any such date is past the horizon anyway
+			run.asap[n] = std::min((uint64_t)UINT32_MAX, std::max(minPredAsap + nbPreds, 1 + maxPredAsap));
+		} else run.asap[n] = 0;
 #ifdef DEBUG
-	std::cout << "Node " << std::to_string(n->num) << " ASAP " << std::to_string(n->asap) << std::endl;
+		std::cout << "Node " << std::to_string(n + 1) << " ASAP " << std::to_string(run.asap[n]) << std::endl;
 #endif
+	}
 }
 
-void preProcessALAP(node* n, uint32_t maxTime) {
-	if(n->nbSuccessors > 0) {
-		uint32_t minSuccAlap = UINT32_MAX;
-		uint32_t maxSuccAlap = 0;
-		for(uint32_t i = 0; i < n->nbSuccessors; ++i) {
-			preProcessALAP(n->successors[i], maxTime);//, t+1);
-			minSuccAlap = std::min(minSuccAlap, n->successors[i]->alap);
-			maxSuccAlap = std::max(maxSuccAlap, n->successors[i]->alap);
-		}
-		n->alap = std::min(maxSuccAlap - 2*n->nbSuccessors, minSuccAlap - 1);
-		if(n->alap > maxSuccAlap) {
-			std::cout << "WARNING: ALAP computation overflows. Any result will be wrong. Please relax maximum deadline." << std::endl;
-		}
-	} else n->alap = maxTime;
-	// WARNING the negative (overflow) case CAN happen and isn't handled here
-
+// ALAP goes below 0 when the horizon is too small, hence the signed copy
+void preProcessALAP(run_context& run, std::vector<node>& order, std::vector<int64_t>& alap) {
+	const dag* d = run.graph;
+	for(uint32_t i = d->nbNodes; i-- > 0;) {
+		node n = order[i];
+		uint32_t nbSuccs = nbSuccessors(d, n);
+		const node* succs = successors(d, n);
+		if(nbSuccs > 0) {
+			int64_t minSuccAlap = INT64_MAX;
+			int64_t maxSuccAlap = INT64_MIN;
+			for(uint32_t k = 0; k < nbSuccs; ++k) {
+				minSuccAlap = std::min(minSuccAlap, alap[succs[k]]);
+				maxSuccAlap = std::max(maxSuccAlap, alap[succs[k]]);
+			}
+			alap[n] = std::min(maxSuccAlap - 2 * (int64_t)nbSuccs, minSuccAlap - 1);
+		} else alap[n] = run.maxTime;
+		run.alap[n] = (uint32_t)std::max(alap[n], (int64_t)0);
 #ifdef DEBUG
-	std::cout << "Node " << std::to_string(n->num) << " ALAP " << std::to_string(n->alap) << std::endl;
+		std::cout << "Node " << std::to_string(n + 1) << " ALAP " << std::to_string(alap[n]) << std::endl;
 #endif
-}
-
-void preProcessDAG(dag* d, uint32_t maxTime) {
-	// compute ALAP
-	for(uint32_t i = 0; i < d->nbInputNodes; ++i) {
-		preProcessALAP(d->inputNodes[i], maxTime);//, 0);
 	}
+}
 
-	// compute ASAP
-	for(uint32_t i = 0; i < d->nbOutputNodes; ++i) {
-		preProcessASAP(d->outputNodes[i]);//, maxTime-1);
+// Returns false if some node can't be computed within the horizon: its window
+// [ASAP, ALAP] is empty, so the constraints would be unsatisfiable anyway.
+bool preProcessDAG(run_context& run) {
+	const dag* d = run.graph;
+	run.asap.assign(d->nbNodes, UINT32_MAX);
+	run.alap.assign(d->nbNodes, 0);
+	std::vector<node> order(d->nbNodes);
+	// The loaders reject cycles, and the other DAGs are acyclic by construction
+	bool acyclic = topologicalOrder(d, order.data());
+	assert(acyclic);
+	(void)acyclic;
+
+	std::vector<int64_t> alap(d->nbNodes);
+	preProcessASAP(run, order);
+	preProcessALAP(run, order, alap);
+
+	for(node n = 0; n < d->nbNodes; ++n) {
+		if(nbPredecessors(d, n) > 0 && alap[n] < (int64_t)run.asap[n]) {
+			std::cout << "# unsat: horizon too small, node " << std::to_string(n + 1)
+					<< " can't be computed before date " << std::to_string(run.asap[n])
+					<< " but must be by date " << std::to_string(alap[n]) << std::endl;
+			return false;
+		}
 	}
+	return true;
 }
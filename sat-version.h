@@ -9,22 +9,150 @@
 
 #include <z3++.h>
 #include <vector>
+#include <unordered_map>
 #include "datastruct.h"
+#include "cardinality.h"
+#include "report.h"
+#include "export.h"
 
 using namespace z3;
 
 typedef struct {
 	expr symbol;
-	node* n;
+	node n;
 	rule r;
 	uint32_t date;
+	uint32_t id; // position in the symbol list, stable for the whole run
 } registered_symbol;
 
 typedef std::vector<registered_symbol> symbol_list;
 
-registered_symbol lookupRegisteredSymbol(std::string name, symbol_list& symbols);
-void addRegisteredSymbol(registered_symbol rs, symbol_list& symbols);
+// Slot value for a (node, rule, date) triple that has no symbol yet.
+#define NO_SYMBOL UINT32_MAX
 
-void dagToConstraints(dag* _dag, uint32_t nbRedPebbles, uint32_t maxTime, context& ctx, expr_vector& existingConstraints, symbol_list& symbols);
+// Dates at which an event of one rule can happen for one node, bounds
+// included; empty when first > last.
+typedef struct event_window {
+	uint32_t first;
+	uint32_t last;
+} event_window;
+
+// Dense symbol table: one slot per (node, rule, date), allocated once for the
+// whole horizon. A slot holds the id of the symbol in the list, so that
+// requesting an existing symbol is a single array load.
+typedef struct {
+	symbol_list symbols;
+	std::vector<uint32_t> slots;
+	uint32_t nbNodes;
+	uint32_t nbDates;
+	// One per (node, rule): no symbol is created outside of it
+	std::vector<event_window> windows;
+	// Z3 declaration id -> symbol id, to decode models without names
+	std::unordered_map<unsigned, uint32_t> decls;
+} symbol_table;
+
+// How the limited number of red pebbles is expressed
+typedef enum pebble_encoding {
+	PEBBLES_SUM,                // for each t, one sum over every event up to t
+	PEBBLES_PREFIX,             // one "live pebbles at t" integer per step, defined from t-1
+	PEBBLES_SEQUENTIAL_COUNTER, // pure CNF, see cardinality.h
+	PEBBLES_TOTALIZER,
+	PEBBLES_SORTING_NETWORK
+} pebble_encoding;
+#define NB_PEBBLE_ENCODINGS (PEBBLES_SORTING_NETWORK + 1)
+extern const char* pebbleEncodingNames[];
+extern const char* amoEncodingNames[];
+
+// Which formulation of the pebble game is built. The rules differ slightly,
+// and so can the answers: see liveness-version.h
+typedef enum encoding_engine {
+	ENGINE_INTERVAL, // events only, dependences through disjunctions over time windows
+	ENGINE_LIVENESS  // explicit red/blue state per node and date, cf. liveness-version.h
+} encoding_engine;
+
+typedef struct encoding_options {
+	encoding_engine engine;
+	pebble_encoding pebbles;
+	amo_encoding amo; // at most one event per date, at most one compute per node
+	bool intervalCache; // share the interval disjunctions of the interval engine
+	bool eventWindows; // restrict R1, R2 and R4 to the dates where they can be useful
+	bool symmetryBreaking; // lex-leader constraints from the automorphisms of the DAG
+	bool orderingLemmas; // redundant constraints from the reachability closure, cf. closure.h
+	uint32_t ioBudget; // at most this many R1 + R2 events, or NO_IO_BUDGET
+	// Below nbRedPebbles, the register count is symbolic: any count in
+	// [minRegisters, nbRedPebbles] can be chosen at check time by assuming
+	// its registerGuard. NO_SYMBOLIC_REGISTERS for a constant count.
+	uint32_t minRegisters;
+} encoding_options;
+
+#define NO_IO_BUDGET UINT32_MAX
+#define NO_SYMBOLIC_REGISTERS UINT32_MAX
+
+// "R3(5,7)": node 5 (numbered from 1) computed at date 7
+std::string symbolName(node n, rule _rule, uint32_t time);
+
+// Shared by the encoding engines. Outside the window of the rule, the event
+// can't happen: this is false, and no symbol is created.
+expr ruleSymbol(node n, rule _rule, uint32_t time, context& ctx, symbol_table& symbols);
+
+// R1 and R2 symbols before the horizon: what the I/O cost counts
+expr_vector ioSymbols(symbol_table& symbols, uint32_t maxTime, context& ctx);
+// Cardinality encoding matching the pebble encoding, for the other limits
+card_encoding cardEncoding(pebble_encoding pebbles);
+
+// "At most k registers", for a symbolic register count. Each guard implies the
+// next one, and the one for nbRedPebbles always holds.
+expr registerGuard(uint32_t k, context& ctx);
+bool symbolicRegisters(uint32_t nbRedPebbles, encoding_options& options);
+// Forbid count[offset + k] for the register count k, with count a unary counter
+void boundUnaryCount(expr_vector& count, uint32_t offset, uint32_t nbRedPebbles, encoding_options& options, context& ctx, expr_vector& constraints);
+
+// True if the constraints only contain Boolean variables and clauses
+bool isPureBoolean(encoding_options& options);
+
+// Schedule indexed by date, decoded from a model
+typedef std::vector<schedule_event> schedule;
+
+// Data of one encoding, for one horizon. The DAG is shared and never written,
+// so that several encodings can be built from it at once.
+typedef struct run_context {
+	const dag* graph;
+	uint32_t maxTime;
+	std::vector<uint32_t> asap; // earliest compute date of each node
+	std::vector<uint32_t> alap; // latest one, 0 if below
+	run_report* report; // phase timings, NULL if not measured
+	constraint_sink* sink; // where the constraints go as they are built, NULL to keep them
+} run_context;
+
+// With a sink, writes the constraints built so far and empties the vector;
+// the builders call it after each node or phase
+void flushConstraints(run_context& run, expr_vector& constraints);
+
+void noTwoSimultaneousNodes(expr_vector& constraints, symbol_list& symbols, run_context& run, amo_encoding amo, context& ctx);
+
+// Every window is the whole horizon
+void initSymbolTable(const dag* _dag, uint32_t maxTime, symbol_table& table);
+registered_symbol* findRegisteredSymbol(node n, rule r, uint32_t date, symbol_table& table);
+
+registered_symbol* findRegisteredDecl(func_decl& decl, symbol_table& table);
+
+// "computed_by(n,t)" auxiliaries, shared by the redundant constraints: each one
+// implies an R3 of n at some date up to t among the symbols already created.
+typedef std::unordered_map<uint64_t, expr> prefix_cache;
+expr computedBy(node n, uint32_t t, context& ctx, expr_vector& constraints, symbol_table& symbols, prefix_cache& prefixes);
+registered_symbol& addRegisteredSymbol(registered_symbol rs, symbol_table& table);
+
+schedule decodeModel(model& m, uint32_t maxTime, symbol_table& table);
+
+// Returns false, with the constraints reduced to false, when the ASAP/ALAP
+// windows show that the horizon is too small. The time of each phase goes to
+// the report, if any. With a sink, the constraints are written to it as they
+// are built, and the vector ends up empty.
+bool dagToConstraints(const dag* _dag, uint32_t nbRedPebbles, uint32_t maxTime, encoding_options& options, context& ctx, expr_vector& existingConstraints, symbol_table& symbols,
+		run_report* report = NULL, constraint_sink* sink = NULL);
+
+// Number of distinct terms in the constraints (shared sub-terms are counted once),
+// and of the variables among them if nbVariables isn't NULL
+uint64_t formulaSize(expr_vector& constraints, uint64_t* nbVariables = NULL);
 
 #endif /* SAT_VERSION_H_ */
@@ -0,0 +1,140 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+#include "search.h"
+#include <chrono>
+
+check_result checkBudget(solver& s, budget_guards& guards, uint32_t budget);
+double solverCounter(solver& s, const char* name);
+
+budget_guards buildTimeGuards(symbol_table& symbols, uint32_t maxTime, context& ctx, expr_vector& constraints) {
+	budget_guards guards = { GUARD_HORIZON, expr_vector(ctx) };
+	for(uint32_t t = 0; t < maxTime; ++t)
+		guards.literals.push_back(ctx.bool_const(("active(" + std::to_string(t) + ")").c_str()));
+
+	for(symbol_list::iterator i = symbols.symbols.begin(); i < symbols.symbols.end(); ++i) {
+		if(i->date < maxTime)
+			constraints.push_back(guards.literals[i->date] || !i->symbol);
+	}
+	return guards;
+}
+
+budget_guards buildIOGuards(symbol_table& symbols, uint32_t maxTime, uint32_t maxBudget, context& ctx, expr_vector& constraints) {
+	// The totalizer only has fresh variables as outputs, which can be assumed
+	expr_vector io = ioSymbols(symbols, maxTime, ctx);
+	budget_guards guards = { GUARD_IO_COUNT, unaryCounter(io, maxBudget + 1, CARD_TOTALIZER, ctx, constraints) };
+	return guards;
+}
+
+expr_vector budgetAssumptions(budget_guards& guards, uint32_t budget) {
+	expr_vector assumptions(guards.literals.ctx());
+	if(guards.kind == GUARD_HORIZON) {
+		for(uint32_t t = budget; t < guards.literals.size(); ++t)
+			assumptions.push_back(!guards.literals[t]);
+	} else if(budget < guards.literals.size()) {
+		assumptions.push_back(!guards.literals[budget]);
+	}
+	return assumptions;
+}
+
+check_result checkBudget(solver& s, budget_guards& guards, uint32_t budget) {
+	expr_vector assumptions = budgetAssumptions(guards, budget);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	check_result result = s.check(assumptions);
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+	std::cout << "# Budget " << std::to_string(budget) << ": "
+			<< (result == sat ? "sat" : (result == unsat ? "unsat" : "unknown"))
+			<< " (" << std::chrono::duration<double>(end - start).count() << " s)" << std::endl;
+	return result;
+}
+
+budget_search_result budgetSearch(solver& s, budget_guards& guards, uint32_t minBudget, uint32_t maxBudget, search_strategy strategy) {
+	budget_search_result ret = { NO_BUDGET, NO_BUDGET, 0 };
+
+	if(strategy == SEARCH_LINEAR) {
+		for(uint32_t budget = minBudget; budget <= maxBudget; ++budget) {
+			check_result result = checkBudget(s, guards, budget);
+			ret.nbChecks += 1;
+			if(result == sat) {
+				ret.tightestSat = budget;
+				break;
+			} else if(result == unsat) {
+				ret.tightestUnsat = budget;
+			} else {
+				break; // can't conclude on monotonicity past an unknown
+			}
+		}
+	} else if(strategy == SEARCH_BINARY) {
+		uint32_t lo = minBudget, hi = maxBudget;
+		while(lo <= hi) {
+			uint32_t budget = lo + (hi - lo) / 2;
+			check_result result = checkBudget(s, guards, budget);
+			ret.nbChecks += 1;
+			if(result == sat) {
+				ret.tightestSat = budget;
+				if(budget == 0)
+					break;
+				hi = budget - 1;
+			} else if(result == unsat) {
+				ret.tightestUnsat = budget;
+				lo = budget + 1;
+			} else {
+				break;
+			}
+		}
+	}
+
+	return ret;
+}
+
+// SAT and SMT cores name their counters differently: "sat conflicts" or "conflicts"
+double solverCounter(solver& s, const char* name) {
+	stats st = s.statistics();
+	std::string satName = std::string("sat ") + name;
+	double ret = 0;
+	for(uint32_t i = 0; i < st.size(); ++i) {
+		std::string key = st.key(i);
+		if(key == name || key == satName)
+			ret += st.is_uint(i) ? st.uint_value(i) : st.double_value(i);
+	}
+	return ret;
+}
+
+budget_search_result registerSearch(solver& s, uint32_t minRegisters, uint32_t maxRegisters) {
+	budget_search_result ret = { NO_BUDGET, NO_BUDGET, 0 };
+	context& ctx = s.ctx();
+
+	for(uint32_t k = minRegisters; k <= maxRegisters; ++k) {
+		// Each conflict learns a clause; the solver may have dropped some since
+		double learned = solverCounter(s, "conflicts");
+		expr_vector assumptions(ctx);
+		assumptions.push_back(registerGuard(k, ctx));
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		check_result result = s.check(assumptions);
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		ret.nbChecks += 1;
+
+		std::cout << "# Registers " << std::to_string(k) << ": "
+				<< (result == sat ? "sat" : (result == unsat ? "unsat" : "unknown"))
+				<< " (" << std::chrono::duration<double>(end - start).count() << " s, "
+				<< (uint64_t)(solverCounter(s, "conflicts") - learned) << " conflicts, "
+				<< "up to " << (uint64_t)learned << " clauses learned by the previous checks)" << std::endl;
+
+		if(result == sat) {
+			ret.tightestSat = k;
+			break;
+		} else if(result == unsat) {
+			ret.tightestUnsat = k;
+		} else {
+			break;
+		}
+	}
+
+	return ret;
+}
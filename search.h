@@ -0,0 +1,66 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+/*
+ * Incremental search for the I/O lower bound. The encoding is built once for
+ * the largest budget, with assumption literals that can shrink it:
+ * - when the budget is the horizon, every date gets a literal that, when
+ *   false, forbids every event at that date;
+ * - when the budget is the number of R1 + R2 events, the literals are the
+ *   outputs of a unary counter over these events.
+ * Asking for a smaller budget is then a check() under assumptions on the same
+ * solver, so that the clauses learned by one check are reused by the next ones.
+ * The register count can be searched the same way, with registerGuard.
+ */
+
+#ifndef SEARCH_H_
+#define SEARCH_H_
+
+#include <z3++.h>
+#include "sat-version.h"
+
+using namespace z3;
+
+// Budget not reached by the search
+#define NO_BUDGET UINT32_MAX
+
+typedef enum search_strategy {
+	SEARCH_NONE,
+	SEARCH_LINEAR, // from the smallest budget up, until the first sat
+	SEARCH_BINARY
+} search_strategy;
+
+typedef struct budget_search_result {
+	uint32_t tightestUnsat; // largest budget proven unsat
+	uint32_t tightestSat;   // smallest budget found sat
+	uint32_t nbChecks;
+} budget_search_result;
+
+typedef enum guard_kind {
+	GUARD_HORIZON, // literals[t] must be true for any event to happen at date t
+	GUARD_IO_COUNT // literals[b] is implied by "more than b R1 + R2 events"
+} guard_kind;
+
+typedef struct budget_guards {
+	guard_kind kind;
+	expr_vector literals;
+} budget_guards;
+
+budget_guards buildTimeGuards(symbol_table& symbols, uint32_t maxTime, context& ctx, expr_vector& constraints);
+budget_guards buildIOGuards(symbol_table& symbols, uint32_t maxTime, uint32_t maxBudget, context& ctx, expr_vector& constraints);
+
+// Assumptions restricting the problem to the given budget
+expr_vector budgetAssumptions(budget_guards& guards, uint32_t budget);
+
+budget_search_result budgetSearch(solver& s, budget_guards& guards, uint32_t minBudget, uint32_t maxBudget, search_strategy strategy);
+
+// Same, over the register count of an encoding built with a symbolic one
+// (see encoding_options::minRegisters): from the smallest count up, until the
+// first sat. Each check reports its conflicts, and how many clauses the
+// previous checks learned that it could start from.
+budget_search_result registerSearch(solver& s, uint32_t minRegisters, uint32_t maxRegisters);
+
+#endif /* SEARCH_H_ */
@@ -0,0 +1,145 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+#include "simulator.h"
+#include <vector>
+#include <algorithm>
+
+// Pebbles of a replay, one bit per node
+typedef struct pebbles {
+	std::vector<bool> red;
+	std::vector<bool> blue;
+	std::vector<bool> computed;
+	uint32_t nbRed;
+} pebbles;
+
+violation replayEvent(const dag* d, schedule_event& e, uint32_t nbRedPebbles, pebbles& p, simulation_report& report);
+
+const char* violationMessage(violation v) {
+	switch(v) {
+		case VIOLATION_NONE:
+			return "none";
+		case VIOLATION_REGISTERS_FULL:
+			return "Register file full";
+		case VIOLATION_NOT_IN_MEMORY:
+			return "Value not in memory on load";
+		case VIOLATION_ALREADY_IN_REGISTER:
+			return "Value already in a register";
+		case VIOLATION_NOT_IN_REGISTER:
+			return "Value not in registers";
+		case VIOLATION_INPUT_COMPUTED:
+			return "Input computed";
+		case VIOLATION_COMPUTED_TWICE:
+			return "Node computed twice";
+		case VIOLATION_DEPENDENCY:
+			return "Dependency not satisfied";
+		case VIOLATION_NOT_COMPUTED:
+			return "Node never computed";
+		case VIOLATION_OUTPUT_NOT_STORED:
+			return "Output not in memory at the end";
+		default:
+			return "INVALID";
+	}
+}
+
+violation replayEvent(const dag* d, schedule_event& e, uint32_t nbRedPebbles, pebbles& p, simulation_report& report) {
+	node n = e.n;
+	switch(e.r) {
+	case RULE_R1:
+		if(p.red[n])
+			return VIOLATION_ALREADY_IN_REGISTER;
+		if(!p.blue[n])
+			return VIOLATION_NOT_IN_MEMORY;
+		if(p.nbRed == nbRedPebbles)
+			return VIOLATION_REGISTERS_FULL;
+		p.red[n] = true;
+		p.nbRed += 1;
+		report.nbLoads += 1;
+		break;
+
+	case RULE_R2:
+		if(!p.red[n])
+			return VIOLATION_NOT_IN_REGISTER;
+		p.red[n] = false;
+		p.blue[n] = true;
+		p.nbRed -= 1;
+		report.nbStores += 1;
+		break;
+
+	case RULE_R3:
+		if(nbPredecessors(d, n) == 0)
+			return VIOLATION_INPUT_COMPUTED;
+		if(p.computed[n])
+			return VIOLATION_COMPUTED_TWICE;
+		if(p.red[n])
+			return VIOLATION_ALREADY_IN_REGISTER;
+		for(uint32_t i = 0; i < nbPredecessors(d, n); ++i) {
+			if(!p.red[predecessors(d, n)[i]])
+				return VIOLATION_DEPENDENCY;
+		}
+		if(p.nbRed == nbRedPebbles)
+			return VIOLATION_REGISTERS_FULL;
+		p.red[n] = true;
+		p.computed[n] = true;
+		p.nbRed += 1;
+		report.nbComputes += 1;
+		break;
+
+	case RULE_R4:
+		if(!p.red[n])
+			return VIOLATION_NOT_IN_REGISTER;
+		p.red[n] = false;
+		p.blue[n] = false;
+		p.nbRed -= 1;
+		report.nbDeletes += 1;
+		break;
+
+	default:
+		break;
+	}
+	return VIOLATION_NONE;
+}
+
+simulation_report simulateSchedule(const dag* d, schedule& events, uint32_t nbRedPebbles) {
+	simulation_report report = { VIOLATION_NONE, NO_DATE, NO_NODE, 0, 0, 0, 0, 0 };
+
+	pebbles p;
+	p.red.assign(d->nbNodes, false);
+	p.blue.assign(d->nbNodes, false);
+	p.computed.assign(d->nbNodes, false);
+	p.nbRed = 0;
+	for(uint32_t i = 0; i < d->nbInputNodes; ++i)
+		p.blue[d->inputNodes[i]] = true;
+
+	for(uint32_t t = 0; t < events.size(); ++t) {
+		if(events[t].n == NO_NODE)
+			continue;
+		report.firstViolation = replayEvent(d, events[t], nbRedPebbles, p, report);
+		if(report.firstViolation != VIOLATION_NONE) {
+			report.violationDate = t;
+			report.violationNode = events[t].n;
+			return report;
+		}
+		report.peakRegisters = std::max(report.peakRegisters, p.nbRed);
+	}
+
+	for(node n = 0; n < d->nbNodes; ++n) {
+		if(nbPredecessors(d, n) > 0 && !p.computed[n]) {
+			report.firstViolation = VIOLATION_NOT_COMPUTED;
+			report.violationNode = n;
+			return report;
+		}
+	}
+	for(uint32_t i = 0; i < d->nbOutputNodes; ++i) {
+		node n = d->outputNodes[i];
+		if(nbPredecessors(d, n) > 0 && !p.blue[n]) {
+			report.firstViolation = VIOLATION_OUTPUT_NOT_STORED;
+			report.violationNode = n;
+			return report;
+		}
+	}
+	return report;
+}
@@ -0,0 +1,64 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+/*
+ * Replay of a schedule in the red-blue pebble game, as the engines model it:
+ * - R1 loads a value from memory (blue) into a free register (red);
+ * - R2 stores a value from its register to memory, which frees the register;
+ * - R3 computes a node, once, into a free register, with every predecessor
+ *   in a register;
+ * - R4 deletes a value from its register and from memory, for good.
+ * Inputs start in memory, and in the end every node is computed and every
+ * output is in memory. The pebbles are bitsets owned by the replay: the DAG
+ * isn't modified, so a schedule can be checked from any thread.
+ */
+
+#ifndef SIMULATOR_H_
+#define SIMULATOR_H_
+
+#include "datastruct.h"
+#include "sat-version.h"
+
+typedef enum violation {
+	VIOLATION_NONE,
+	VIOLATION_REGISTERS_FULL,  // R1 or R3 with every register taken
+	VIOLATION_NOT_IN_MEMORY,   // R1 of a value not in memory
+	VIOLATION_ALREADY_IN_REGISTER, // R1 or R3 of a value already in a register
+	VIOLATION_NOT_IN_REGISTER, // R2 or R4 of a value not in a register
+	VIOLATION_INPUT_COMPUTED,
+	VIOLATION_COMPUTED_TWICE,
+	VIOLATION_DEPENDENCY,      // R3 with a predecessor not in a register
+	VIOLATION_NOT_COMPUTED,    // at the end of the schedule
+	VIOLATION_OUTPUT_NOT_STORED
+} violation;
+
+#define NO_DATE UINT32_MAX
+
+typedef struct simulation_report {
+	violation firstViolation;
+	uint32_t violationDate; // NO_DATE for the checks at the end
+	node violationNode;
+	uint32_t nbLoads;
+	uint32_t nbStores;
+	uint32_t nbComputes;
+	uint32_t nbDeletes;
+	uint32_t peakRegisters;
+} simulation_report;
+
+// Stops at the first violation. Idle dates (NO_NODE) are skipped.
+simulation_report simulateSchedule(const dag* d, schedule& events, uint32_t nbRedPebbles);
+
+inline bool isValid(simulation_report& report) {
+	return report.firstViolation == VIOLATION_NONE;
+}
+
+inline uint32_t ioCost(simulation_report& report) {
+	return report.nbLoads + report.nbStores;
+}
+
+const char* violationMessage(violation v);
+
+#endif /* SIMULATOR_H_ */
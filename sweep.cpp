@@ -0,0 +1,222 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+#include "sweep.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+// Shared between the threads, under the mutex
+typedef struct sweep_state {
+	std::mutex lock;
+	std::condition_variable changed;
+	sweep_result* result;
+	std::vector<context*> running; // context of each running cell, to interrupt it
+	uint32_t nbRunning;
+	uint32_t nbFinished; // threads out of work
+	const dag* _dag;
+	uint32_t horizon;
+	encoding_options* options;
+} sweep_state;
+
+uint32_t cellIndex(sweep_result& result, uint32_t budget, uint32_t registers);
+bool pickCell(sweep_state& state, uint32_t& budget, uint32_t& registers);
+void setCell(sweep_state& state, uint32_t budget, uint32_t registers, cell_status status);
+void propagateResult(sweep_state& state, uint32_t budget, uint32_t registers, check_result result);
+check_result solveCell(sweep_state& state, uint32_t budget, uint32_t registers, context& ctx);
+void runSweepThread(sweep_state* state);
+
+uint32_t cellIndex(sweep_result& result, uint32_t budget, uint32_t registers) {
+	uint32_t width = result.budgets.max - result.budgets.min + 1;
+	return (registers - result.registers.min) * width + (budget - result.budgets.min);
+}
+
+// The open cell furthest from any cell of its row that is decided or being
+// solved, the bounds of the row counting as decided. Solving it halves the
+// largest open run of the row, as in a binary search.
+bool pickCell(sweep_state& state, uint32_t& budget, uint32_t& registers) {
+	sweep_result& result = *state.result;
+	uint32_t bestDistance = 0;
+
+	for(uint32_t r = result.registers.min; r <= result.registers.max; ++r) {
+		int64_t previous = (int64_t)result.budgets.min - 1;
+		for(int64_t b = result.budgets.min; b <= (int64_t)result.budgets.max + 1; ++b) {
+			if(b <= result.budgets.max && result.cells[cellIndex(result, b, r)] == CELL_OPEN)
+				continue;
+			// Open run between previous and b, both excluded
+			if(b - previous > 1) {
+				uint32_t distance = (b - previous) / 2;
+				if(distance > bestDistance) {
+					bestDistance = distance;
+					budget = previous + distance;
+					registers = r;
+				}
+			}
+			previous = b;
+		}
+	}
+
+	return bestDistance > 0;
+}
+
+void setCell(sweep_state& state, uint32_t budget, uint32_t registers, cell_status status) {
+	uint32_t i = cellIndex(*state.result, budget, registers);
+	cell_status& cell = state.result->cells[i];
+	if(cell == CELL_RUNNING && state.running[i] != NULL)
+		state.running[i]->interrupt(); // its result is already known
+	if(cell == CELL_OPEN || cell == CELL_RUNNING || cell == CELL_UNKNOWN)
+		cell = status;
+}
+
+void propagateResult(sweep_state& state, uint32_t budget, uint32_t registers, check_result result) {
+	sweep_result& grid = *state.result;
+	if(result == sat) {
+		for(uint32_t r = registers; r <= grid.registers.max; ++r)
+			for(uint32_t b = budget; b <= grid.budgets.max; ++b)
+				setCell(state, b, r, CELL_SAT);
+	} else if(result == unsat) {
+		for(uint32_t r = grid.registers.min; r <= registers; ++r)
+			for(uint32_t b = grid.budgets.min; b <= budget; ++b)
+				setCell(state, b, r, CELL_UNSAT);
+	} else {
+		uint32_t i = cellIndex(grid, budget, registers);
+		if(grid.cells[i] == CELL_RUNNING)
+			grid.cells[i] = CELL_UNKNOWN;
+	}
+}
+
+check_result solveCell(sweep_state& state, uint32_t budget, uint32_t registers, context& ctx) {
+	encoding_options options = *state.options;
+	uint32_t maxTime = budget;
+	if(state.horizon != NO_HORIZON) {
+		maxTime = state.horizon;
+		options.ioBudget = budget;
+	}
+
+	expr_vector constraints(ctx);
+	symbol_table symbols;
+	dagToConstraints(state._dag, registers, maxTime, options, ctx, constraints, symbols);
+
+	solver s = isPureBoolean(options) ? solver(ctx, "QF_FD") : solver(ctx);
+	s.add(mk_and(constraints).simplify());
+	{
+		// A cell decided while it was being built is not solved at all. One
+		// decided from here on gets interrupted, until its check() is back.
+		std::lock_guard<std::mutex> guard(state.lock);
+		uint32_t i = cellIndex(*state.result, budget, registers);
+		cell_status cell = state.result->cells[i];
+		if(cell == CELL_SAT || cell == CELL_UNSAT)
+			return unknown;
+		state.running[i] = &ctx;
+	}
+	return s.check();
+}
+
+void runSweepThread(sweep_state* state) {
+	std::unique_lock<std::mutex> guard(state->lock);
+	while(true) {
+		uint32_t budget, registers;
+		if(!pickCell(*state, budget, registers)) {
+			if(state->nbRunning == 0) {
+				state->nbFinished += 1;
+				state->changed.notify_all();
+				break;
+			}
+			// A running cell may still open or close a run
+			state->changed.wait(guard);
+			continue;
+		}
+
+		uint32_t i = cellIndex(*state->result, budget, registers);
+		state->result->cells[i] = CELL_RUNNING;
+		state->nbRunning += 1;
+		state->result->nbSolved += 1;
+
+		context ctx;
+		guard.unlock();
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		check_result result = unknown;
+		try {
+			result = solveCell(*state, budget, registers, ctx);
+		} catch(exception& e) {
+			result = unknown; // interrupted, or out of resources
+		}
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+		guard.lock();
+		state->running[i] = NULL;
+		state->nbRunning -= 1;
+		cell_status status = state->result->cells[i];
+		std::cout << "# Cell (" << std::to_string(budget) << ", " << std::to_string(registers) << "): "
+				<< (result == sat ? "sat" : (result == unsat ? "unsat" : "unknown"));
+		if(result == unknown && (status == CELL_SAT || status == CELL_UNSAT))
+			std::cout << ", interrupted, inferred " << (status == CELL_SAT ? "sat" : "unsat");
+		std::cout << " (" << std::chrono::duration<double>(end - start).count() << " s)" << std::endl;
+		propagateResult(*state, budget, registers, result);
+		state->changed.notify_all();
+	}
+}
+
+sweep_result paretoSweep(const dag* _dag, sweep_range budgets, sweep_range registers, uint32_t horizon,
+		encoding_options& options, uint32_t nbThreads) {
+	sweep_result result;
+	result.budgets = budgets;
+	result.registers = registers;
+	result.nbSolved = 0;
+	uint32_t nbCells = (budgets.max - budgets.min + 1) * (registers.max - registers.min + 1);
+	result.cells.assign(nbCells, CELL_OPEN);
+
+	sweep_state state;
+	state.result = &result;
+	state.running.assign(nbCells, NULL);
+	state.nbRunning = 0;
+	state.nbFinished = 0;
+	state._dag = _dag;
+	state.horizon = horizon;
+	state.options = &options;
+
+	std::vector<std::thread> workers;
+	for(uint32_t i = 0; i < nbThreads; ++i)
+		workers.push_back(std::thread(runSweepThread, &state));
+
+	{
+		// Z3 drops an interrupt that comes before check(), so keep
+		// interrupting the running cells already decided until they are back
+		std::unique_lock<std::mutex> guard(state.lock);
+		while(state.nbFinished < nbThreads) {
+			for(uint32_t i = 0; i < nbCells; ++i) {
+				cell_status cell = result.cells[i];
+				if(state.running[i] != NULL && (cell == CELL_SAT || cell == CELL_UNSAT))
+					state.running[i]->interrupt();
+			}
+			state.changed.wait_for(guard, std::chrono::milliseconds(10));
+		}
+	}
+	for(uint32_t i = 0; i < nbThreads; ++i)
+		workers[i].join();
+
+	return result;
+}
+
+void printFrontierCSV(sweep_result& result, std::ostream& out) {
+	out << "registers,tightest_unsat,tightest_sat" << std::endl;
+	for(uint32_t r = result.registers.min; r <= result.registers.max; ++r) {
+		// Cells are unsat, then unknown, then sat along a row
+		int64_t tightestUnsat = -1, tightestSat = -1;
+		for(uint32_t b = result.budgets.min; b <= result.budgets.max; ++b) {
+			cell_status status = result.cells[cellIndex(result, b, r)];
+			if(status == CELL_UNSAT)
+				tightestUnsat = b;
+			else if(status == CELL_SAT && tightestSat < 0)
+				tightestSat = b;
+		}
+		out << std::to_string(r) << ","
+				<< (tightestUnsat >= 0 ? std::to_string(tightestUnsat) : "") << ","
+				<< (tightestSat >= 0 ? std::to_string(tightestSat) : "") << std::endl;
+	}
+}
@@ -0,0 +1,57 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+/*
+ * Sweep over a grid of (budget, registers) cells, to chart the I/O lower bound
+ * against the size of the register file. The problem is monotone in both
+ * parameters: unsat at (b, r) implies unsat for every b' <= b and r' <= r, and
+ * sat implies sat for every b' >= b and r' >= r. Every result is propagated
+ * that way, and the threads pick the cell that splits the largest open run of
+ * its row, so that each row is searched by bisection while the other rows
+ * benefit from its results.
+ */
+
+#ifndef SWEEP_H_
+#define SWEEP_H_
+
+#include <z3++.h>
+#include <vector>
+#include <iostream>
+#include "sat-version.h"
+
+using namespace z3;
+
+// The budget is the deadline, not a number of loads and stores
+#define NO_HORIZON UINT32_MAX
+
+typedef struct sweep_range {
+	uint32_t min;
+	uint32_t max;
+} sweep_range;
+
+typedef enum cell_status {
+	CELL_OPEN,
+	CELL_RUNNING,
+	CELL_SAT,
+	CELL_UNSAT,
+	CELL_UNKNOWN
+} cell_status;
+
+typedef struct sweep_result {
+	sweep_range budgets;
+	sweep_range registers;
+	// Row-major, one row per register count
+	std::vector<cell_status> cells;
+	uint32_t nbSolved; // cells sent to the solver, the others were inferred
+} sweep_result;
+
+sweep_result paretoSweep(const dag* _dag, sweep_range budgets, sweep_range registers, uint32_t horizon,
+		encoding_options& options, uint32_t nbThreads);
+
+// One line per register count: tightest unsat and sat budgets, empty if none
+void printFrontierCSV(sweep_result& result, std::ostream& out);
+
+#endif /* SWEEP_H_ */
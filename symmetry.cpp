@@ -0,0 +1,221 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+#include "symmetry.h"
+#include <algorithm>
+
+typedef std::vector<uint32_t> colouring;
+
+uint32_t refine(const dag* d, colouring& colours);
+colouring individualise(const dag* d, colouring& colours, node n);
+bool firstNonSingleton(colouring& colours, uint32_t& cell);
+bool sameCellSizes(colouring& left, colouring& right);
+bool isAutomorphism(const dag* d, permutation& sigma);
+bool matchPaths(const dag* d, colouring& left, colouring& right, permutation& found, uint64_t& budget);
+std::vector<bool> orbit(node n, std::vector<permutation>& generators, uint32_t nbNodes);
+
+// Colour each node by its colour and the colours of its predecessors and
+// successors, until no cell splits. The new colours are ranks of signatures,
+// so they don't depend on how the nodes are numbered. Returns the number of colours.
+uint32_t refine(const dag* d, colouring& colours) {
+	uint32_t nbColours = 0;
+	std::vector<std::vector<uint32_t> > signatures(d->nbNodes);
+	std::vector<node> byColour(d->nbNodes);
+	while(true) {
+		for(node n = 0; n < d->nbNodes; ++n) {
+			std::vector<uint32_t>& sig = signatures[n];
+			sig.clear();
+			sig.push_back(colours[n]);
+			size_t first = sig.size();
+			for(uint32_t i = 0; i < nbPredecessors(d, n); ++i)
+				sig.push_back(colours[predecessors(d, n)[i]]);
+			std::sort(sig.begin() + first, sig.end());
+			sig.push_back(UINT32_MAX); // between predecessors and successors
+			first = sig.size();
+			for(uint32_t i = 0; i < nbSuccessors(d, n); ++i)
+				sig.push_back(colours[successors(d, n)[i]]);
+			std::sort(sig.begin() + first, sig.end());
+			byColour[n] = n;
+		}
+		std::sort(byColour.begin(), byColour.end(), [&signatures](node a, node b) {
+			return signatures[a] < signatures[b];
+		});
+
+		uint32_t rank = 0;
+		for(uint32_t i = 0; i < d->nbNodes; ++i) {
+			if(i > 0 && signatures[byColour[i]] != signatures[byColour[i - 1]])
+				rank += 1;
+			colours[byColour[i]] = rank;
+		}
+		uint32_t refined = d->nbNodes == 0 ? 0 : rank + 1;
+		if(refined == nbColours)
+			return nbColours;
+		nbColours = refined;
+	}
+}
+
+// Same colour on both sides of the search for the individualised node
+colouring individualise(const dag* d, colouring& colours, node n) {
+	colouring ret = colours;
+	ret[n] = d->nbNodes;
+	refine(d, ret);
+	return ret;
+}
+
+bool firstNonSingleton(colouring& colours, uint32_t& cell) {
+	std::vector<uint32_t> sizes(colours.size(), 0);
+	for(uint32_t i = 0; i < colours.size(); ++i)
+		sizes[colours[i]] += 1;
+	for(cell = 0; cell < sizes.size(); ++cell) {
+		if(sizes[cell] > 1)
+			return true;
+	}
+	return false;
+}
+
+bool sameCellSizes(colouring& left, colouring& right) {
+	std::vector<int64_t> balance(left.size(), 0);
+	for(uint32_t i = 0; i < left.size(); ++i) {
+		balance[left[i]] += 1;
+		balance[right[i]] -= 1;
+	}
+	for(uint32_t i = 0; i < balance.size(); ++i) {
+		if(balance[i] != 0)
+			return false;
+	}
+	return true;
+}
+
+bool isAutomorphism(const dag* d, permutation& sigma) {
+	std::vector<node> image, expected;
+	for(node n = 0; n < d->nbNodes; ++n) {
+		if(nbSuccessors(d, n) != nbSuccessors(d, sigma[n]))
+			return false;
+		image.clear();
+		expected.clear();
+		for(uint32_t i = 0; i < nbSuccessors(d, n); ++i) {
+			image.push_back(sigma[successors(d, n)[i]]);
+			expected.push_back(successors(d, sigma[n])[i]);
+		}
+		std::sort(image.begin(), image.end());
+		std::sort(expected.begin(), expected.end());
+		if(image != expected)
+			return false;
+	}
+	return true;
+}
+
+// The left side always individualises the first node of the first cell that
+// isn't a singleton; the right side tries every node of that cell.
+bool matchPaths(const dag* d, colouring& left, colouring& right, permutation& found, uint64_t& budget) {
+	if(!sameCellSizes(left, right))
+		return false;
+
+	uint32_t cell;
+	if(!firstNonSingleton(left, cell)) {
+		// Both discrete: the nodes of the same colour correspond
+		std::vector<node> leftOf(d->nbNodes);
+		for(node n = 0; n < d->nbNodes; ++n)
+			leftOf[left[n]] = n;
+		found.assign(d->nbNodes, NO_NODE);
+		for(node n = 0; n < d->nbNodes; ++n)
+			found[leftOf[right[n]]] = n;
+		return isAutomorphism(d, found);
+	}
+
+	node v = 0;
+	while(left[v] != cell)
+		v++;
+	colouring nextLeft = individualise(d, left, v);
+	for(node w = 0; w < d->nbNodes; ++w) {
+		if(right[w] != cell)
+			continue;
+		if(budget == 0)
+			return false;
+		budget -= 1;
+		colouring nextRight = individualise(d, right, w);
+		if(matchPaths(d, nextLeft, nextRight, found, budget))
+			return true;
+	}
+	return false;
+}
+
+std::vector<bool> orbit(node n, std::vector<permutation>& generators, uint32_t nbNodes) {
+	std::vector<bool> reached(nbNodes, false);
+	std::vector<node> todo(1, n);
+	reached[n] = true;
+	while(!todo.empty()) {
+		node m = todo.back();
+		todo.pop_back();
+		for(uint32_t i = 0; i < generators.size(); ++i) {
+			node image = generators[i][m];
+			if(!reached[image]) {
+				reached[image] = true;
+				todo.push_back(image);
+			}
+		}
+	}
+	return reached;
+}
+
+// Generators of the automorphism group, level by level along the first path:
+// at each level, one automorphism mapping the individualised node to each
+// node of its cell that the generators of this level don't reach yet.
+std::vector<permutation> dagAutomorphisms(const dag* d, uint64_t& budget) {
+	std::vector<permutation> generators;
+	colouring colours(d->nbNodes, 0);
+	refine(d, colours);
+
+	uint32_t cell;
+	while(budget > 0 && firstNonSingleton(colours, cell)) {
+		node v = 0;
+		while(colours[v] != cell)
+			v++;
+		colouring left = individualise(d, colours, v);
+
+		std::vector<permutation> level;
+		std::vector<bool> reached = orbit(v, level, d->nbNodes);
+		for(node w = v + 1; w < d->nbNodes && budget > 0; ++w) {
+			if(colours[w] != cell || reached[w])
+				continue;
+			budget -= 1;
+			colouring right = individualise(d, colours, w);
+			permutation sigma;
+			if(matchPaths(d, left, right, sigma, budget)) {
+				level.push_back(sigma);
+				generators.push_back(sigma);
+				reached = orbit(v, level, d->nbNodes);
+			}
+		}
+		colours = left;
+	}
+	return generators;
+}
+
+void symmetryBreakingConstraints(const dag* d, std::vector<permutation>& generators, uint32_t maxTime,
+		context& ctx, expr_vector& constraints, symbol_table& symbols, prefix_cache& prefixes) {
+	for(uint32_t g = 0; g < generators.size(); ++g) {
+		permutation& sigma = generators[g];
+		// First computed node moved, and the node mapped onto it
+		node u = 0;
+		while(u < d->nbNodes && (sigma[u] == u || nbPredecessors(d, u) == 0))
+			u++;
+		if(u == d->nbNodes)
+			continue; // only moves inputs
+		node v = 0;
+		while(sigma[v] != u)
+			v++;
+
+		// c(u) < c(v): when v is computed, u already is
+		for(uint32_t t = 0; t < maxTime; ++t) {
+			registered_symbol* computeV = findRegisteredSymbol(v, RULE_R3, t, symbols);
+			if(computeV == NULL)
+				continue;
+			expr uBefore = t > 0 ? computedBy(u, t - 1, ctx, constraints, symbols, prefixes) : ctx.bool_val(false);
+			constraints.push_back(implies(computeV->symbol, uBefore));
+		}
+	}
+}
@@ -0,0 +1,46 @@
+/*
+ * SMT Computation of IO Lower Bounds
+ * Corentin Ferry - 2018
+ *
+*/
+
+/*
+ * Symmetry breaking. An automorphism of the DAG maps every schedule to
+ * another schedule with the same cost, so only the schedules whose compute
+ * dates are lexicographically smallest in their orbit (nodes taken in index
+ * order) need to be searched. Each node is computed once and no two events
+ * share a date, so for a generator sigma the lex-leader constraint comes down
+ * to c(u) < c(sigma^-1(u)), with u the first computed node moved by sigma.
+ *
+ * The generators are found by individualisation and refinement: the nodes
+ * are coloured by their predecessors and successors until the colouring is
+ * stable, then one node of a cell is individualised on each side and the
+ * search goes on until both colourings are discrete and define a permutation,
+ * which is kept if it preserves the edges.
+ */
+
+#ifndef SYMMETRY_H_
+#define SYMMETRY_H_
+
+#include <z3++.h>
+#include <vector>
+#include "datastruct.h"
+#include "sat-version.h"
+
+using namespace z3;
+
+// Number of refinements the search may do before giving up with the
+// generators found so far
+#define SYMMETRY_SEARCH_BUDGET 20000
+
+// permutation[n] is the image of node n
+typedef std::vector<node> permutation;
+
+// Decreases the budget by the refinements done, down to 0 if it runs out
+std::vector<permutation> dagAutomorphisms(const dag* d, uint64_t& budget);
+
+// Lex-leader constraints on the R3 symbols already in the table
+void symmetryBreakingConstraints(const dag* d, std::vector<permutation>& generators, uint32_t maxTime,
+		context& ctx, expr_vector& constraints, symbol_table& symbols, prefix_cache& prefixes);
+
+#endif /* SYMMETRY_H_ */